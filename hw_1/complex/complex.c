@@ -25,3 +25,179 @@ Complex multiply(Complex a, Complex b) {
 double magnitude(Complex a) {
     return sqrt(a.real * a.real + a.im * a.im);
 }
+
+/* Batch functions
+ *
+ * The plain loops below work on the raw doubles of the interleaved array so
+ * the compiler can vectorize them. On x86 the AVX kernels further down handle
+ * two complex numbers per instruction; which version runs is decided at run
+ * time from the CPU's feature flags.
+ */
+
+#if !defined(COMPLEX_NO_SIMD) && defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define COMPLEX_AVX_DISPATCH 1
+#include <immintrin.h>
+#endif
+
+static int simd_allowed = 1;
+
+static void add_n_plain(const Complex * COMPLEX_RESTRICT a, const Complex * COMPLEX_RESTRICT b,
+                        Complex * COMPLEX_RESTRICT out, size_t n) {
+    const double * COMPLEX_RESTRICT x = (const double *) a;
+    const double * COMPLEX_RESTRICT y = (const double *) b;
+    double * COMPLEX_RESTRICT z = (double *) out;
+    for (size_t i = 0; i < 2 * n; i++) {
+        z[i] = x[i] + y[i];
+    }
+}
+
+static void multiply_n_plain(const Complex * COMPLEX_RESTRICT a, const Complex * COMPLEX_RESTRICT b,
+                             Complex * COMPLEX_RESTRICT out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        double re = a[i].real * b[i].real - a[i].im * b[i].im;
+        double im = a[i].real * b[i].im + a[i].im * b[i].real;
+        out[i].real = re;
+        out[i].im = im;
+    }
+}
+
+static void magnitude_n_plain(const Complex * COMPLEX_RESTRICT a, double * COMPLEX_RESTRICT out, size_t n) {
+    for (size_t i = 0; i < n; i++) {
+        out[i] = sqrt(a[i].real * a[i].real + a[i].im * a[i].im);
+    }
+}
+
+static void scale_n_plain(const Complex * COMPLEX_RESTRICT a, double s, Complex * COMPLEX_RESTRICT out, size_t n) {
+    const double * COMPLEX_RESTRICT x = (const double *) a;
+    double * COMPLEX_RESTRICT z = (double *) out;
+    for (size_t i = 0; i < 2 * n; i++) {
+        z[i] = s * x[i];
+    }
+}
+
+#ifdef COMPLEX_AVX_DISPATCH
+
+/* Each 256 bit register holds two complex numbers: [re0, im0, re1, im1] */
+
+__attribute__((target("avx")))
+static void add_n_avx(const Complex * COMPLEX_RESTRICT a, const Complex * COMPLEX_RESTRICT b,
+                      Complex * COMPLEX_RESTRICT out, size_t n) {
+    const double *x = (const double *) a, *y = (const double *) b;
+    double *z = (double *) out;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m256d va = _mm256_loadu_pd(x + 2 * i);
+        __m256d vb = _mm256_loadu_pd(y + 2 * i);
+        _mm256_storeu_pd(z + 2 * i, _mm256_add_pd(va, vb));
+    }
+    add_n_plain(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx")))
+static void multiply_n_avx(const Complex * COMPLEX_RESTRICT a, const Complex * COMPLEX_RESTRICT b,
+                           Complex * COMPLEX_RESTRICT out, size_t n) {
+    const double *x = (const double *) a, *y = (const double *) b;
+    double *z = (double *) out;
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m256d va = _mm256_loadu_pd(x + 2 * i);
+        __m256d vb = _mm256_loadu_pd(y + 2 * i);
+        __m256d b_re = _mm256_movedup_pd(vb);            // [br0, br0, br1, br1]
+        __m256d b_im = _mm256_permute_pd(vb, 0xF);       // [bi0, bi0, bi1, bi1]
+        __m256d a_swap = _mm256_permute_pd(va, 0x5);     // [ai0, ar0, ai1, ar1]
+        __m256d t1 = _mm256_mul_pd(va, b_re);            // [ar*br, ai*br, ...]
+        __m256d t2 = _mm256_mul_pd(a_swap, b_im);        // [ai*bi, ar*bi, ...]
+        _mm256_storeu_pd(z + 2 * i, _mm256_addsub_pd(t1, t2));
+    }
+    multiply_n_plain(a + i, b + i, out + i, n - i);
+}
+
+__attribute__((target("avx")))
+static void magnitude_n_avx(const Complex * COMPLEX_RESTRICT a, double * COMPLEX_RESTRICT out, size_t n) {
+    const double *x = (const double *) a;
+    size_t i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256d v0 = _mm256_loadu_pd(x + 2 * i);         // z0, z1
+        __m256d v1 = _mm256_loadu_pd(x + 2 * i + 4);     // z2, z3
+        __m256d sq = _mm256_hadd_pd(_mm256_mul_pd(v0, v0), _mm256_mul_pd(v1, v1));
+        __m256d r = _mm256_sqrt_pd(sq);                  // [m0, m2, m1, m3]
+        __m128d lo = _mm256_castpd256_pd128(r);
+        __m128d hi = _mm256_extractf128_pd(r, 1);
+        _mm_storeu_pd(out + i, _mm_unpacklo_pd(lo, hi));
+        _mm_storeu_pd(out + i + 2, _mm_unpackhi_pd(lo, hi));
+    }
+    magnitude_n_plain(a + i, out + i, n - i);
+}
+
+__attribute__((target("avx")))
+static void scale_n_avx(const Complex * COMPLEX_RESTRICT a, double s, Complex * COMPLEX_RESTRICT out, size_t n) {
+    const double *x = (const double *) a;
+    double *z = (double *) out;
+    __m256d vs = _mm256_set1_pd(s);
+    size_t i = 0;
+    for (; i + 2 <= n; i += 2) {
+        _mm256_storeu_pd(z + 2 * i, _mm256_mul_pd(vs, _mm256_loadu_pd(x + 2 * i)));
+    }
+    scale_n_plain(a + i, s, out + i, n - i);
+}
+
+#endif
+
+void complex_simd_enable(int enable) {
+    simd_allowed = enable;
+}
+
+int complex_simd_active(void) {
+#ifdef COMPLEX_AVX_DISPATCH
+    static int cpu_has_avx = -1;
+    if (cpu_has_avx < 0) {
+        __builtin_cpu_init();
+        cpu_has_avx = __builtin_cpu_supports("avx") ? 1 : 0;
+    }
+    return simd_allowed && cpu_has_avx;
+#else
+    return 0;
+#endif
+}
+
+void add_n(const Complex * COMPLEX_RESTRICT a, const Complex * COMPLEX_RESTRICT b,
+           Complex * COMPLEX_RESTRICT out, size_t n) {
+#ifdef COMPLEX_AVX_DISPATCH
+    if (complex_simd_active()) {
+        add_n_avx(a, b, out, n);
+        return;
+    }
+#endif
+    add_n_plain(a, b, out, n);
+}
+
+void multiply_n(const Complex * COMPLEX_RESTRICT a, const Complex * COMPLEX_RESTRICT b,
+                Complex * COMPLEX_RESTRICT out, size_t n) {
+#ifdef COMPLEX_AVX_DISPATCH
+    if (complex_simd_active()) {
+        multiply_n_avx(a, b, out, n);
+        return;
+    }
+#endif
+    multiply_n_plain(a, b, out, n);
+}
+
+void magnitude_n(const Complex * COMPLEX_RESTRICT a, double * COMPLEX_RESTRICT out, size_t n) {
+#ifdef COMPLEX_AVX_DISPATCH
+    if (complex_simd_active()) {
+        magnitude_n_avx(a, out, n);
+        return;
+    }
+#endif
+    magnitude_n_plain(a, out, n);
+}
+
+void scale_n(const Complex * COMPLEX_RESTRICT a, double s, Complex * COMPLEX_RESTRICT out, size_t n) {
+#ifdef COMPLEX_AVX_DISPATCH
+    if (complex_simd_active()) {
+        scale_n_avx(a, s, out, n);
+        return;
+    }
+#endif
+    scale_n_plain(a, s, out, n);
+}
@@ -3,6 +3,15 @@
 
 /*! @file */
 
+#include <stddef.h>
+
+/* restrict is C99; C++ compilers spell it __restrict */
+#ifdef __cplusplus
+#define COMPLEX_RESTRICT __restrict
+#else
+#define COMPLEX_RESTRICT restrict
+#endif
+
 /*! \brief Complex number structure and method definitions
  *
  * A complex number is a struct with a real part and an imaginary part.
@@ -37,4 +46,51 @@ Complex multiply(Complex a, Complex b);
  */
 double magnitude(Complex a);
 
+/*! Add two arrays of complex numbers element by element
+ *  \param a The first array of n summands
+ *  \param b The second array of n summands
+ *  \param out The array of n sums, which must not overlap a or b
+ *  \param n The number of elements
+ */
+void add_n(const Complex * COMPLEX_RESTRICT a, const Complex * COMPLEX_RESTRICT b,
+           Complex * COMPLEX_RESTRICT out, size_t n);
+
+/*! Multiply two arrays of complex numbers element by element
+ *  \param a The first array of n terms
+ *  \param b The second array of n terms
+ *  \param out The array of n products, which must not overlap a or b
+ *  \param n The number of elements
+ */
+void multiply_n(const Complex * COMPLEX_RESTRICT a, const Complex * COMPLEX_RESTRICT b,
+                Complex * COMPLEX_RESTRICT out, size_t n);
+
+/*! Calculate the magnitude of every element of an array
+ *  \param a The array of n complex numbers
+ *  \param out The array of n magnitudes
+ *  \param n The number of elements
+ */
+void magnitude_n(const Complex * COMPLEX_RESTRICT a, double * COMPLEX_RESTRICT out, size_t n);
+
+/*! Multiply every element of an array by a real factor
+ *  \param a The array of n complex numbers
+ *  \param s The real scale factor
+ *  \param out The array of n scaled numbers, which must not overlap a
+ *  \param n The number of elements
+ */
+void scale_n(const Complex * COMPLEX_RESTRICT a, double s, Complex * COMPLEX_RESTRICT out, size_t n);
+
+/*! Allow or forbid the hand-written SIMD kernels used by the batch functions
+ *
+ *  By default the batch functions check once whether the CPU supports AVX
+ *  and use intrinsics if it does, falling back to plain loops otherwise.
+ *  Defining COMPLEX_NO_SIMD at compile time removes the intrinsics entirely.
+ *  \param enable Zero to always use the plain loops, non-zero to allow SIMD
+ */
+void complex_simd_enable(int enable);
+
+/*! Whether the batch functions currently run the SIMD kernels
+ *  \return Non-zero if the AVX kernels are in use
+ */
+int complex_simd_active(void);
+
 #endif // COMPLEX_H
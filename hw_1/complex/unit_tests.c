@@ -30,4 +30,62 @@ namespace {
         EXPECT_EQ(result, 5.0);
     }
 
+    /* Fills n complex numbers with an arbitrary but repeatable pattern */
+    void fill(Complex *a, size_t n, double seed) {
+        for (size_t i = 0; i < n; i++) {
+            a[i].real = seed * (i % 7) - 2.5;
+            a[i].im = 1.0 / (i + seed) - (i % 3);
+        }
+    }
+
+    /* Runs every batch function against the scalar ones for several lengths */
+    void check_batch_functions(void) {
+        const size_t sizes[] = {0, 1, 2, 3, 4, 7, 33, 1000};
+        for (size_t size : sizes) {
+            Complex a[1000], b[1000], out[1000];
+            double mags[1000];
+            fill(a, size, 1.5);
+            fill(b, size, -0.75);
+
+            add_n(a, b, out, size);
+            for (size_t i = 0; i < size; i++) {
+                Complex expected = add(a[i], b[i]);
+                EXPECT_DOUBLE_EQ(out[i].real, expected.real);
+                EXPECT_DOUBLE_EQ(out[i].im, expected.im);
+            }
+
+            multiply_n(a, b, out, size);
+            for (size_t i = 0; i < size; i++) {
+                Complex expected = multiply(a[i], b[i]);
+                EXPECT_DOUBLE_EQ(out[i].real, expected.real);
+                EXPECT_DOUBLE_EQ(out[i].im, expected.im);
+            }
+
+            magnitude_n(a, mags, size);
+            for (size_t i = 0; i < size; i++) {
+                EXPECT_DOUBLE_EQ(mags[i], magnitude(a[i]));
+            }
+
+            Complex factor = {-3.0, 0.0};
+            scale_n(a, -3.0, out, size);
+            for (size_t i = 0; i < size; i++) {
+                Complex expected = multiply(a[i], factor);
+                EXPECT_DOUBLE_EQ(out[i].real, expected.real);
+                EXPECT_DOUBLE_EQ(out[i].im, expected.im);
+            }
+        }
+    }
+
+    TEST(Complex, BatchMatchesScalar) {
+        complex_simd_enable(1);
+        check_batch_functions();
+    }
+
+    TEST(Complex, BatchWithoutSimdMatchesScalar) {
+        complex_simd_enable(0);
+        EXPECT_FALSE(complex_simd_active());
+        check_batch_functions();
+        complex_simd_enable(1);
+    }
+
 }
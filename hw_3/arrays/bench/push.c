@@ -0,0 +1,100 @@
+// Push throughput of DynamicArray: push() from an empty array, push()
+// after reserve(), append_n() in blocks, and push_front(), against the
+// previous growth scheme, which calloc'ed each new buffer and copied the
+// elements one at a time through DynamicArray_get().
+//
+// Build with `make bench` and run bin/bench_push.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "dynamic_array.h"
+
+static double now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// The growth step this module used to have
+static void legacy_extend(DynamicArray *da) {
+    int size = DynamicArray_size(da);
+    int new_capacity = 2 * da->capacity;
+    double *new_buffer = (double *)calloc(new_capacity, sizeof(double));
+    int new_origin = (new_capacity - size) / 2;
+    for (int i = 0; i < size; i++) {
+        new_buffer[new_origin + i] = DynamicArray_get(da, i);
+    }
+    free(da->buffer);
+    da->buffer = new_buffer;
+    da->capacity = new_capacity;
+    da->origin = new_origin;
+    da->end = new_origin + size;
+}
+
+static void legacy_push(DynamicArray *da, double value) {
+    if (da->end >= da->capacity) {
+        legacy_extend(da);
+    }
+    da->buffer[da->end++] = value;
+}
+
+enum { LEGACY, PUSH, RESERVE, APPEND, PUSH_FRONT };
+
+// Nanoseconds per element to build an array of n elements, best of repeats
+static double run(int kind, int n, int repeats) {
+    static double block[256];
+    double best = 1e30, checksum = 0;
+    for (int r = 0; r < repeats; r++) {
+        double start = now_ns();
+        DynamicArray *da = DynamicArray_new();
+        switch (kind) {
+            case LEGACY:
+                for (int i = 0; i < n; i++) legacy_push(da, i);
+                break;
+            case PUSH:
+                for (int i = 0; i < n; i++) DynamicArray_push(da, i);
+                break;
+            case RESERVE:
+                DynamicArray_reserve(da, n);
+                for (int i = 0; i < n; i++) DynamicArray_push(da, i);
+                break;
+            case APPEND:
+                for (int i = 0; i < n; i += 256) {
+                    DynamicArray_append_n(da, block, n - i < 256 ? n - i : 256);
+                }
+                break;
+            case PUSH_FRONT:
+                for (int i = 0; i < n; i++) DynamicArray_push_front(da, i);
+                break;
+        }
+        double elapsed = now_ns() - start;
+        checksum += DynamicArray_last(da);
+        DynamicArray_destroy(da);
+        free(da);
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    if (checksum < 0) {
+        printf("(checksum %g)\n", checksum);
+    }
+    return best / n;
+}
+
+int main(void) {
+    const char *names[] = {"legacy push", "push", "reserve + push", "append_n x256", "push_front"};
+    printf("%-16s", "ns/element");
+    for (int n = 1000; n <= 10000000; n *= 10) {
+        printf(" %10d", n);
+    }
+    printf("\n");
+    for (int kind = LEGACY; kind <= PUSH_FRONT; kind++) {
+        printf("%-16s", names[kind]);
+        for (int n = 1000; n <= 10000000; n *= 10) {
+            printf(" %10.3f", run(kind, n, n >= 1000000 ? 5 : 50));
+        }
+        printf("\n");
+    }
+    return 0;
+}
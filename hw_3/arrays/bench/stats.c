@@ -0,0 +1,80 @@
+// Time per element of the summary statistics: min, max, mean and sum as
+// separate calls, against the same four computed the old way, through
+// DynamicArray_get() one element at a time, and against one
+// DynamicArray_stats() call, which also gives the variance. Arrays run
+// from 1e3 elements, in L1, to 1e7, in memory.
+//
+// Build with `make bench` and run bin/bench_stats.
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include "dynamic_array.h"
+
+static double now_ns(void) {
+    struct timespec t;
+    clock_gettime(CLOCK_MONOTONIC, &t);
+    return t.tv_sec * 1e9 + t.tv_nsec;
+}
+
+// min, max, mean and sum as this module used to compute them
+static double legacy_four(const DynamicArray *da) {
+    int n = DynamicArray_size(da);
+    double min = DynamicArray_get(da, 0), max = min, sum = 0, mean_sum = 0;
+    for (int i = 1; i < n; i++) {
+        double value = DynamicArray_get(da, i);
+        if (value < min) min = value;
+    }
+    for (int i = 1; i < n; i++) {
+        double value = DynamicArray_get(da, i);
+        if (value > max) max = value;
+    }
+    for (int i = 0; i < n; i++) mean_sum += DynamicArray_get(da, i);
+    for (int i = 0; i < n; i++) sum += DynamicArray_get(da, i);
+    return min + max + mean_sum / n + sum;
+}
+
+static double four(const DynamicArray *da) {
+    return DynamicArray_min(da) + DynamicArray_max(da) + DynamicArray_mean(da) + DynamicArray_sum(da);
+}
+
+static double fused(const DynamicArray *da) {
+    DynamicArrayStats s;
+    DynamicArray_stats(da, &s);
+    return s.min + s.max + s.mean + s.sum + s.variance;
+}
+
+// Nanoseconds per element, best of repeats
+static double run(double (*f)(const DynamicArray *), const DynamicArray *da, int repeats) {
+    double best = 1e30, checksum = 0;
+    for (int r = 0; r < repeats; r++) {
+        double start = now_ns();
+        checksum += f(da);
+        double elapsed = now_ns() - start;
+        if (elapsed < best) {
+            best = elapsed;
+        }
+    }
+    if (checksum != checksum) {
+        printf("(checksum %g)\n", checksum);
+    }
+    return best / DynamicArray_size(da);
+}
+
+int main(void) {
+    printf("%10s %14s %14s %14s\n", "ns/element", "legacy x4", "separate x4", "stats");
+    srand(520);
+    for (int n = 1000; n <= 10000000; n *= 10) {
+        DynamicArray *da = DynamicArray_new();
+        DynamicArray_reserve(da, n);
+        for (int i = 0; i < n; i++) {
+            DynamicArray_push(da, rand() / (double) RAND_MAX);
+        }
+        int repeats = n <= 100000 ? 200 : 10;
+        printf("%10d %14.3f %14.3f %14.3f\n", n, run(legacy_four, da, repeats),
+               run(four, da, repeats), run(fused, da, repeats));
+        DynamicArray_destroy(da);
+        free(da);
+    }
+    return 0;
+}
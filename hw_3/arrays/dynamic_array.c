@@ -4,13 +4,19 @@
 #include <string.h>
 #include <assert.h>
 #include <math.h>
+#include <limits.h>
 
 static int array_count = 0;
 
 // Private function prototypes
 static int index_to_offset(const DynamicArray *da, int index);
 static int out_of_buffer(DynamicArray *da, int offset);
-static void extend_buffer(DynamicArray *da);
+static void reallocate(DynamicArray *da, int new_capacity, int new_origin);
+static void extend_back(DynamicArray *da, int n);
+static void extend_front(DynamicArray *da, int n);
+static double *fill_scratch(DynamicArray *da);
+static void select_kth(double *a, int left, int right, int k);
+static void select_ranks(double *a, int left, int right, const int *ranks, int first, int last);
 int compare_doubles(const void *a, const void *b);
 
 // Convert index to buffer offset
@@ -23,22 +29,59 @@ static int out_of_buffer(DynamicArray *da, int offset) {
     return offset < 0 || offset >= da->capacity;
 }
 
-// Extend buffer to accommodate more elements
-static void extend_buffer(DynamicArray *da) {
-    int new_capacity = 2 * da->capacity;
-    double *new_buffer = (double *)calloc(new_capacity, sizeof(double));
-    int new_origin = (new_capacity - DynamicArray_size(da)) / 2;
-    int new_end = new_origin + DynamicArray_size(da);
-
-    for (int i = 0; i < DynamicArray_size(da); i++) {
-        new_buffer[new_origin + i] = DynamicArray_get(da, i);
+// Move the elements to a buffer of new_capacity starting at new_origin.
+// When the origin stays put this is a realloc, which can often grow the
+// block in place; otherwise the elements are copied with one memcpy.
+// Slots outside the elements are left uninitialized.
+static void reallocate(DynamicArray *da, int new_capacity, int new_origin) {
+    int size = DynamicArray_size(da);
+    assert(new_capacity >= new_origin + size && new_capacity > 0);
+    if (new_origin == da->origin) {
+        double *new_buffer = (double *)realloc(da->buffer, (size_t) new_capacity * sizeof(double));
+        assert(new_buffer != NULL);
+        da->buffer = new_buffer;
+    } else {
+        double *new_buffer = (double *)malloc((size_t) new_capacity * sizeof(double));
+        assert(new_buffer != NULL);
+        memcpy(new_buffer + new_origin, da->buffer + da->origin, (size_t) size * sizeof(double));
+        free(da->buffer);
+        da->buffer = new_buffer;
     }
-
-    free(da->buffer);
-    da->buffer = new_buffer;
     da->capacity = new_capacity;
     da->origin = new_origin;
-    da->end = new_end;
+    da->end = new_origin + size;
+}
+
+// Make room for n more elements after the end. The capacity at least
+// doubles, so a run of pushes costs amortized constant time, and the
+// elements stay where they are.
+static void extend_back(DynamicArray *da, int n) {
+    assert(n >= 0 && da->end <= INT_MAX - n);
+    if (da->end + n <= da->capacity) {
+        return;
+    }
+    int new_capacity = da->capacity <= INT_MAX / 2 ? 2 * da->capacity : INT_MAX;
+    if (new_capacity < da->end + n) {
+        new_capacity = da->end + n;
+    }
+    reallocate(da, new_capacity, da->origin);
+}
+
+// Make room for n more elements before the origin. The elements move to
+// the back of a buffer at least twice as large, with half the free space
+// in front of them.
+static void extend_front(DynamicArray *da, int n) {
+    int size = DynamicArray_size(da);
+    assert(n >= 0 && size <= INT_MAX - n);
+    if (da->origin >= n) {
+        return;
+    }
+    int new_capacity = da->capacity <= INT_MAX / 2 ? 2 * da->capacity : INT_MAX;
+    if (new_capacity < size + n) {
+        new_capacity = size + n;
+    }
+    int back = (new_capacity - size - n) / 2;
+    reallocate(da, new_capacity, new_capacity - size - back);
 }
 
 // Create a new dynamic array
@@ -48,6 +91,8 @@ DynamicArray *DynamicArray_new(void) {
     da->buffer = (double *)calloc(da->capacity, sizeof(double));
     da->origin = da->capacity / 2;
     da->end = da->origin;
+    da->scratch = NULL;
+    da->scratch_capacity = 0;
     array_count++;
     return da;
 }
@@ -55,26 +100,58 @@ DynamicArray *DynamicArray_new(void) {
 // Destroy a dynamic array
 void DynamicArray_destroy(DynamicArray *da) {
     free(da->buffer);
+    free(da->scratch);
     da->buffer = NULL;
+    da->scratch = NULL;
+    da->scratch_capacity = 0;
     array_count--;
 }
 
+// Make room for n elements in total, so the array can grow to that size
+// by pushing or setting without reallocating
+void DynamicArray_reserve(DynamicArray *da, int n) {
+    assert(da != NULL && n >= 0);
+    int size = DynamicArray_size(da);
+    if (n > size) {
+        extend_back(da, n - size);
+    }
+}
+
+// Free the unused capacity. The buffer keeps room for at least one element.
+void DynamicArray_shrink(DynamicArray *da) {
+    assert(da != NULL);
+    int size = DynamicArray_size(da);
+    if (da->origin > 0) {
+        memmove(da->buffer, da->buffer + da->origin, (size_t) size * sizeof(double));
+        da->origin = 0;
+        da->end = size;
+    }
+    reallocate(da, size > 0 ? size : 1, 0);
+}
+
+// Number of elements the buffer can hold
+int DynamicArray_capacity(const DynamicArray *da) {
+    assert(da->buffer != NULL);
+    return da->capacity;
+}
+
 // Return the number of elements in the array
 int DynamicArray_size(const DynamicArray *da) {
     assert(da->buffer != NULL);
     return da->end - da->origin;
 }
 
-// Set an element in the array at the specified index
+// Set an element in the array at the specified index. Setting past the
+// end grows the array, and the elements in between are zero.
 void DynamicArray_set(DynamicArray *da, int index, double value) {
-    assert(da != NULL);
-    while (index >= DynamicArray_size(da)) {
-        extend_buffer(da);
-    }
-    da->buffer[index_to_offset(da, index)] = value;
-    if (index >= DynamicArray_size(da)) {
+    assert(da != NULL && index >= 0);
+    int size = DynamicArray_size(da);
+    if (index >= size) {
+        extend_back(da, index + 1 - size);
+        memset(da->buffer + da->end, 0, (size_t) (index - size) * sizeof(double));
         da->end = index_to_offset(da, index + 1);
     }
+    da->buffer[index_to_offset(da, index)] = value;
 }
 
 // Get an element from the array at the specified index
@@ -86,58 +163,384 @@ double DynamicArray_get(const DynamicArray *da, int index) {
     return da->buffer[index_to_offset(da, index)];
 }
 
-// Mathematical operations
-double DynamicArray_min(const DynamicArray *da) {
-    assert(da != NULL && DynamicArray_size(da) > 0);
-    double min = da->buffer[da->origin];
-    for (int i = 1; i < DynamicArray_size(da); i++) {
-        double value = DynamicArray_get(da, i);
-        if (value < min) {
-            min = value;
+// Printing
+char *DynamicArray_to_string(const DynamicArray *da) {
+    assert(da->buffer != NULL);
+    int size = DynamicArray_size(da);
+    // Each element takes at most 317 characters ("%.5f" of -DBL_MAX) plus a comma
+    size_t length = 3 + (size_t) size * 320;
+    char *str = (char *)malloc(length);
+    char *p = str;
+    *p++ = '[';
+    for (int i = 0; i < size; i++) {
+        p += snprintf(p, length - (p - str), i == 0 ? "%.5f" : ",%.5f", da->buffer[da->origin + i]);
+    }
+    *p++ = ']';
+    *p = '\0';
+    return str;
+}
+
+void DynamicArray_print_debug_info(const DynamicArray *da) {
+    char *s = DynamicArray_to_string(da);
+    printf("  %s\n", s);
+    printf("  capacity: %d\n  origin: %d\n  end: %d\n  size: %d\n\n",
+           da->capacity, da->origin, da->end, DynamicArray_size(da));
+    free(s);
+}
+
+// Operations
+void DynamicArray_push(DynamicArray *da, double value) {
+    assert(da->buffer != NULL);
+    if (out_of_buffer(da, da->end)) {
+        extend_back(da, 1);
+    }
+    da->buffer[da->end++] = value;
+}
+
+void DynamicArray_push_front(DynamicArray *da, double value) {
+    assert(da->buffer != NULL);
+    if (out_of_buffer(da, da->origin - 1)) {
+        extend_front(da, 1);
+    }
+    da->buffer[--da->origin] = value;
+}
+
+// Append n values with one copy
+void DynamicArray_append_n(DynamicArray *da, const double *values, int n) {
+    assert(da->buffer != NULL && n >= 0 && (values != NULL || n == 0));
+    extend_back(da, n);
+    if (n > 0) {
+        memcpy(da->buffer + da->end, values, (size_t) n * sizeof(double));
+    }
+    da->end += n;
+}
+
+double DynamicArray_pop(DynamicArray *da) {
+    assert(DynamicArray_size(da) > 0);
+    return da->buffer[--da->end];
+}
+
+double DynamicArray_pop_front(DynamicArray *da) {
+    assert(DynamicArray_size(da) > 0);
+    return da->buffer[da->origin++];
+}
+
+DynamicArray *DynamicArray_map(const DynamicArray *da, double (*f)(double)) {
+    assert(da->buffer != NULL);
+    int size = DynamicArray_size(da);
+    DynamicArray *result = DynamicArray_new();
+    DynamicArray_reserve(result, size);
+    for (int i = 0; i < size; i++) {
+        result->buffer[result->end++] = f(da->buffer[da->origin + i]);
+    }
+    return result;
+}
+
+// Mathematical operations. These loop over the buffer directly. Each one
+// keeps STATS_LANES independent partial results, which the compiler turns
+// into vector operations without having to reassociate the arithmetic.
+
+#define STATS_LANES 8
+#define STATS_BLOCK 1024   // Elements per block of DynamicArray_stats, which stays in L1
+
+// Sum of n values
+static double lane_sum(const double *x, int n) {
+    double acc[STATS_LANES] = {0};
+    int i = 0;
+    for (; i + STATS_LANES <= n; i += STATS_LANES) {
+        for (int j = 0; j < STATS_LANES; j++) {
+            acc[j] += x[i + j];
+        }
+    }
+    for (int width = STATS_LANES / 2; width > 0; width /= 2) {
+        for (int j = 0; j < width; j++) {
+            acc[j] += acc[j + width];
         }
     }
+    for (; i < n; i++) {
+        acc[0] += x[i];
+    }
+    return acc[0];
+}
+
+// Smallest and largest of n > 0 values
+static void lane_min_max(const double *x, int n, double *min, double *max) {
+    double lo[STATS_LANES], hi[STATS_LANES];
+    for (int j = 0; j < STATS_LANES; j++) {
+        lo[j] = hi[j] = x[0];
+    }
+    int i = 0;
+    for (; i + STATS_LANES <= n; i += STATS_LANES) {
+        for (int j = 0; j < STATS_LANES; j++) {
+            lo[j] = x[i + j] < lo[j] ? x[i + j] : lo[j];
+            hi[j] = x[i + j] > hi[j] ? x[i + j] : hi[j];
+        }
+    }
+    for (; i < n; i++) {
+        lo[0] = x[i] < lo[0] ? x[i] : lo[0];
+        hi[0] = x[i] > hi[0] ? x[i] : hi[0];
+    }
+    for (int j = 1; j < STATS_LANES; j++) {
+        lo[0] = lo[j] < lo[0] ? lo[j] : lo[0];
+        hi[0] = hi[j] > hi[0] ? hi[j] : hi[0];
+    }
+    *min = lo[0];
+    *max = hi[0];
+}
+
+// Sum, smallest and largest of n > 0 values in one loop
+static double lane_sum_min_max(const double *x, int n, double *min, double *max) {
+    double acc[STATS_LANES] = {0}, lo[STATS_LANES], hi[STATS_LANES];
+    for (int j = 0; j < STATS_LANES; j++) {
+        lo[j] = hi[j] = x[0];
+    }
+    int i = 0;
+    for (; i + STATS_LANES <= n; i += STATS_LANES) {
+        for (int j = 0; j < STATS_LANES; j++) {
+            acc[j] += x[i + j];
+            lo[j] = x[i + j] < lo[j] ? x[i + j] : lo[j];
+            hi[j] = x[i + j] > hi[j] ? x[i + j] : hi[j];
+        }
+    }
+    for (int width = STATS_LANES / 2; width > 0; width /= 2) {
+        for (int j = 0; j < width; j++) {
+            acc[j] += acc[j + width];
+        }
+    }
+    for (; i < n; i++) {
+        acc[0] += x[i];
+        lo[0] = x[i] < lo[0] ? x[i] : lo[0];
+        hi[0] = x[i] > hi[0] ? x[i] : hi[0];
+    }
+    for (int j = 1; j < STATS_LANES; j++) {
+        lo[0] = lo[j] < lo[0] ? lo[j] : lo[0];
+        hi[0] = hi[j] > hi[0] ? hi[j] : hi[0];
+    }
+    *min = lo[0];
+    *max = hi[0];
+    return acc[0];
+}
+
+// Sum of squared deviations of n values from mean
+static double lane_squares(const double *x, int n, double mean) {
+    double acc[STATS_LANES] = {0};
+    int i = 0;
+    for (; i + STATS_LANES <= n; i += STATS_LANES) {
+        for (int j = 0; j < STATS_LANES; j++) {
+            double d = x[i + j] - mean;
+            acc[j] += d * d;
+        }
+    }
+    for (int width = STATS_LANES / 2; width > 0; width /= 2) {
+        for (int j = 0; j < width; j++) {
+            acc[j] += acc[j + width];
+        }
+    }
+    for (; i < n; i++) {
+        double d = x[i] - mean;
+        acc[0] += d * d;
+    }
+    return acc[0];
+}
+
+double DynamicArray_min(const DynamicArray *da) {
+    assert(da != NULL && DynamicArray_size(da) > 0);
+    double min, max;
+    lane_min_max(da->buffer + da->origin, DynamicArray_size(da), &min, &max);
     return min;
 }
 
 double DynamicArray_max(const DynamicArray *da) {
     assert(da != NULL && DynamicArray_size(da) > 0);
-    double max = da->buffer[da->origin];
-    for (int i = 1; i < DynamicArray_size(da); i++) {
-        double value = DynamicArray_get(da, i);
-        if (value > max) {
-            max = value;
-        }
-    }
+    double min, max;
+    lane_min_max(da->buffer + da->origin, DynamicArray_size(da), &min, &max);
     return max;
 }
 
 double DynamicArray_mean(const DynamicArray *da) {
     assert(da != NULL && DynamicArray_size(da) > 0);
-    double sum = 0;
-    for (int i = 0; i < DynamicArray_size(da); i++) {
-        sum += DynamicArray_get(da, i);
+    return lane_sum(da->buffer + da->origin, DynamicArray_size(da)) / DynamicArray_size(da);
+}
+
+// Count, sum, min, max, mean and variance in one pass over the buffer.
+// Each block of STATS_BLOCK elements is read from memory once: its sum,
+// min and max come from one loop, and its squared deviations from its own
+// mean from a second loop while it is still in cache. The blocks are then
+// combined with Chan et al.'s pairwise update, so the variance does not
+// suffer the cancellation of the sum-of-squares formula. The variance is
+// the population variance, divided by count. An empty array has count and
+// sum 0 and NAN for the rest.
+void DynamicArray_stats(const DynamicArray *da, DynamicArrayStats *out) {
+    assert(da != NULL && da->buffer != NULL && out != NULL);
+    const double *x = da->buffer + da->origin;
+    int size = DynamicArray_size(da);
+    double sum = 0, mean = 0, m2 = 0, min = NAN, max = NAN;
+    for (int start = 0; start < size; start += STATS_BLOCK) {
+        int n = size - start < STATS_BLOCK ? size - start : STATS_BLOCK;
+        double block_min, block_max;
+        double block_sum = lane_sum_min_max(x + start, n, &block_min, &block_max);
+        double block_mean = block_sum / n;
+        double block_m2 = lane_squares(x + start, n, block_mean);
+
+        double delta = block_mean - mean;
+        double total = (double) start + n;
+        mean += delta * n / total;
+        m2 += block_m2 + delta * delta * ((double) start * n / total);
+        sum += block_sum;
+        min = start == 0 || block_min < min ? block_min : min;
+        max = start == 0 || block_max > max ? block_max : max;
+    }
+    out->count = size;
+    out->sum = sum;
+    out->min = min;
+    out->max = max;
+    out->mean = size > 0 ? mean : NAN;
+    out->variance = size > 0 ? m2 / size : NAN;
+}
+
+// Order statistics. The elements are copied to the array's scratch buffer,
+// which is kept for the next call, and the ranks needed are found there by
+// selection rather than sorting: expected linear time, with a fallback to
+// qsort for any range that selection fails to shrink quickly. Quantiles
+// interpolate linearly between the two nearest ranks, so the median of an
+// even number of elements is the mean of the middle two.
+
+// Copy the elements to the scratch buffer, growing it if needed
+static double *fill_scratch(DynamicArray *da) {
+    int size = DynamicArray_size(da);
+    if (da->scratch_capacity < size) {
+        free(da->scratch);
+        da->scratch = (double *)malloc((size_t) size * sizeof(double));
+        assert(da->scratch != NULL);
+        da->scratch_capacity = size;
     }
-    return sum / DynamicArray_size(da);
+    memcpy(da->scratch, da->buffer + da->origin, (size_t) size * sizeof(double));
+    return da->scratch;
+}
+
+#define SWAP_DOUBLES(x, y) do { double t_ = (x); (x) = (y); (y) = t_; } while (0)
+
+// Rearrange a[left..right] so that a[k] holds the value it would have if
+// the range were sorted, with no larger values before it and no smaller
+// ones after. Floyd and Rivest's algorithm: on large ranges a pivot is
+// first selected from a small sample around the expected position, so each
+// partition leaves only a thin band around k.
+static void select_kth(double *a, int left, int right, int k) {
+    int budget = 64;   // partitions before falling back to qsort
+    while (right > left) {
+        if (k == left || k == right) {
+            // The smallest or largest: one scan
+            int best = left;
+            for (int i = left + 1; i <= right; i++) {
+                if (k == left ? a[i] < a[best] : a[i] > a[best]) {
+                    best = i;
+                }
+            }
+            SWAP_DOUBLES(a[k], a[best]);
+            return;
+        }
+        if (--budget == 0) {
+            qsort(a + left, right - left + 1, sizeof(double), compare_doubles);
+            return;
+        }
+        if (right - left > 600) {
+            double n = right - left + 1, i = k - left + 1;
+            double z = log(n), s = 0.5 * exp(2 * z / 3);
+            double sd = 0.5 * sqrt(z * s * (n - s) / n) * (i < n / 2 ? -1 : 1);
+            int sample_left = (int) fmax(left, k - i * s / n + sd);
+            int sample_right = (int) fmin(right, k + (n - i) * s / n + sd);
+            select_kth(a, sample_left, sample_right, k);
+        }
+        // Partition around the pivot now at a[k]
+        double pivot = a[k];
+        int i = left, j = right;
+        SWAP_DOUBLES(a[left], a[k]);
+        if (a[right] > pivot) {
+            SWAP_DOUBLES(a[right], a[left]);
+        }
+        while (i < j) {
+            SWAP_DOUBLES(a[i], a[j]);
+            i++;
+            j--;
+            while (a[i] < pivot) i++;
+            while (a[j] > pivot) j--;
+        }
+        if (a[left] == pivot) {
+            SWAP_DOUBLES(a[left], a[j]);
+        } else {
+            j++;
+            SWAP_DOUBLES(a[j], a[right]);
+        }
+        if (j <= k) left = j + 1;
+        if (k <= j) right = j - 1;
+    }
+}
+
+// Select every rank in ranks[first..last], which is sorted, within
+// a[left..right]. The middle rank splits the range and the rest are found
+// in the two halves, so later ranks work on ever smaller ranges.
+static void select_ranks(double *a, int left, int right, const int *ranks, int first, int last) {
+    while (first <= last) {
+        int middle = first + (last - first) / 2, k = ranks[middle];
+        select_kth(a, left, right, k);
+        select_ranks(a, left, k - 1, ranks, first, middle - 1);
+        left = k + 1;
+        first = middle + 1;
+    }
+}
+
+static int compare_ints(const void *a, const void *b) {
+    return *(const int *)a - *(const int *)b;
+}
+
+// Several quantiles, each q in [0, 1], in one selection over one copy
+void DynamicArray_quantiles(DynamicArray *da, const double *q, int m, double *out) {
+    assert(da != NULL && DynamicArray_size(da) > 0 && m >= 0);
+    if (m == 0) {
+        return;
+    }
+    int size = DynamicArray_size(da);
+    int *ranks = (int *)malloc(2 * (size_t) m * sizeof(int));
+    int count = 0;
+    for (int i = 0; i < m; i++) {
+        assert(q[i] >= 0.0 && q[i] <= 1.0);
+        double h = (size - 1) * q[i];
+        int low = (int) h;
+        ranks[count++] = low;
+        if (low + 1 < size && h > low) {
+            ranks[count++] = low + 1;
+        }
+    }
+    qsort(ranks, count, sizeof(int), compare_ints);
+    int unique = 0;
+    for (int i = 0; i < count; i++) {
+        if (unique == 0 || ranks[i] != ranks[unique - 1]) {
+            ranks[unique++] = ranks[i];
+        }
+    }
+
+    double *a = fill_scratch(da);
+    select_ranks(a, 0, size - 1, ranks, 0, unique - 1);
+    for (int i = 0; i < m; i++) {
+        double h = (size - 1) * q[i];
+        int low = (int) h;
+        out[i] = h > low ? a[low] + (h - low) * (a[low + 1] - a[low]) : a[low];
+    }
+    free(ranks);
+}
+
+double DynamicArray_quantile(DynamicArray *da, double q) {
+    double result;
+    DynamicArray_quantiles(da, &q, 1, &result);
+    return result;
 }
 
 double DynamicArray_median(DynamicArray *da) {
-    assert(da != NULL && DynamicArray_size(da) > 0);
-    DynamicArray *copy = DynamicArray_copy(da);
-    qsort(copy->buffer + copy->origin, DynamicArray_size(copy), sizeof(double), compare_doubles);
-    double median = (DynamicArray_size(copy) % 2 == 0) ?
-                    (copy->buffer[copy->origin + DynamicArray_size(copy) / 2 - 1] +
-                     copy->buffer[copy->origin + DynamicArray_size(copy) / 2]) / 2.0 :
-                    copy->buffer[copy->origin + DynamicArray_size(copy) / 2];
-    DynamicArray_destroy(copy);
-    return median;
+    return DynamicArray_quantile(da, 0.5);
 }
 
 double DynamicArray_sum(const DynamicArray *da) {
-    double sum = 0;
-    for (int i = 0; i < DynamicArray_size(da); i++) {
-        sum += DynamicArray_get(da, i);
-    }
-    return sum;
+    return lane_sum(da->buffer + da->origin, DynamicArray_size(da));
 }
 
 // Returns the first element in the array
@@ -156,9 +559,7 @@ double DynamicArray_last(const DynamicArray *da) {
 DynamicArray *DynamicArray_copy(const DynamicArray *da) {
     assert(da != NULL);
     DynamicArray *new_da = DynamicArray_new();
-    for (int i = 0; i < DynamicArray_size(da); i++) {
-        DynamicArray_push(new_da, DynamicArray_get(da, i));
-    }
+    DynamicArray_append_n(new_da, da->buffer + da->origin, DynamicArray_size(da));
     return new_da;
 }
 
@@ -174,10 +575,10 @@ DynamicArray *DynamicArray_range(double start, double end, double step) {
 // Concatenate two arrays into a new array
 DynamicArray *DynamicArray_concat(const DynamicArray *a, const DynamicArray *b) {
     assert(a != NULL && b != NULL);
-    DynamicArray *result = DynamicArray_copy(a);
-    for (int i = 0; i < DynamicArray_size(b); i++) {
-        DynamicArray_push(result, DynamicArray_get(b, i));
-    }
+    DynamicArray *result = DynamicArray_new();
+    DynamicArray_reserve(result, DynamicArray_size(a) + DynamicArray_size(b));
+    DynamicArray_append_n(result, a->buffer + a->origin, DynamicArray_size(a));
+    DynamicArray_append_n(result, b->buffer + b->origin, DynamicArray_size(b));
     return result;
 }
 
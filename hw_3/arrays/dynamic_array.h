@@ -9,12 +9,26 @@
 typedef struct {
     int capacity, origin, end;
     double *buffer;
+    double *scratch;        // Working copy for order statistics, reused across calls
+    int scratch_capacity;
 } DynamicArray;
 
+// Summary statistics, from DynamicArray_stats
+typedef struct {
+    int count;
+    double sum, min, max, mean;
+    double variance;        // Population variance
+} DynamicArrayStats;
+
 // Constructors / Destructors
 DynamicArray *DynamicArray_new(void);
 void DynamicArray_destroy(DynamicArray *);
 
+// Capacity
+void DynamicArray_reserve(DynamicArray *, int);
+void DynamicArray_shrink(DynamicArray *);
+int DynamicArray_capacity(const DynamicArray *);
+
 // Getters / Setters
 void DynamicArray_set(DynamicArray *, int, double);
 double DynamicArray_get(const DynamicArray *, int);
@@ -27,6 +41,7 @@ void DynamicArray_print_debug_info(const DynamicArray *);
 // Operations
 void DynamicArray_push(DynamicArray *, double);
 void DynamicArray_push_front(DynamicArray *, double);
+void DynamicArray_append_n(DynamicArray *, const double *, int);
 double DynamicArray_pop(DynamicArray *);
 double DynamicArray_pop_front(DynamicArray *);
 
@@ -37,7 +52,10 @@ double DynamicArray_min(const DynamicArray *);
 double DynamicArray_max(const DynamicArray *);
 double DynamicArray_mean(const DynamicArray *);
 double DynamicArray_median(DynamicArray *);
+double DynamicArray_quantile(DynamicArray *, double);
+void DynamicArray_quantiles(DynamicArray *, const double *, int, double *);
 double DynamicArray_sum(const DynamicArray *);
+void DynamicArray_stats(const DynamicArray *, DynamicArrayStats *);
 double DynamicArray_first(const DynamicArray *);
 double DynamicArray_last(const DynamicArray *);
 
@@ -45,7 +63,7 @@ double DynamicArray_last(const DynamicArray *);
 DynamicArray *DynamicArray_copy(const DynamicArray *);
 DynamicArray *DynamicArray_range(double, double, double);
 DynamicArray *DynamicArray_concat(const DynamicArray *, const DynamicArray *);
-DynamicArray *DynamicArray_take(DynamicArray *, int);
+DynamicArray *DynamicArray_take(const DynamicArray *, int);
 
 // Lifecycle and validity
 int DynamicArray_num_arrays(void);
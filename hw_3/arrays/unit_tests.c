@@ -2,6 +2,8 @@
 #include <float.h> /* defines DBL_EPSILON */
 #include "dynamic_array.h"
 #include "gtest/gtest.h"
+#include <algorithm>
+#include <vector>
 
 #define X 1.2345
 
@@ -126,4 +128,194 @@ namespace {
         DynamicArray_destroy(y);                    
     }         
 
-}
\ No newline at end of file
+    TEST(DynamicArray, SetZeroFillsGap) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, 1);
+        DynamicArray_push(da, 2);
+        DynamicArray_pop(da);
+        DynamicArray_set(da, 100000, X);
+        ASSERT_EQ(DynamicArray_size(da), 100001);
+        ASSERT_EQ(DynamicArray_get(da, 0), 1);
+        for (int i = 1; i < 100000; i++) {
+            ASSERT_EQ(DynamicArray_get(da, i), 0.0);
+        }
+        ASSERT_EQ(DynamicArray_get(da, 100000), X);
+        ASSERT_LE(DynamicArray_capacity(da), 2 * 100001 + DYNAMIC_ARRAY_INITIAL_CAPACITY);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, ReserveAppendShrink) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push_front(da, -1);
+        DynamicArray_reserve(da, 1000);
+        int capacity = DynamicArray_capacity(da);
+        double * buffer = da->buffer;
+        for (int i = 0; i < 999; i++) {
+            DynamicArray_push(da, i);
+        }
+        ASSERT_EQ(DynamicArray_capacity(da), capacity);
+        ASSERT_EQ(da->buffer, buffer);   // no reallocation
+
+        double values[500];
+        for (int i = 0; i < 500; i++) {
+            values[i] = 999 + i;
+        }
+        DynamicArray_append_n(da, values, 500);
+        DynamicArray_append_n(da, NULL, 0);
+        ASSERT_EQ(DynamicArray_size(da), 1500);
+        ASSERT_EQ(DynamicArray_first(da), -1);
+        for (int i = 1; i < 1500; i++) {
+            ASSERT_EQ(DynamicArray_get(da, i), i - 1);
+        }
+
+        DynamicArray_pop_front(da);
+        DynamicArray_shrink(da);
+        ASSERT_EQ(DynamicArray_capacity(da), 1499);
+        ASSERT_EQ(DynamicArray_size(da), 1499);
+        ASSERT_EQ(DynamicArray_first(da), 0);
+        ASSERT_EQ(DynamicArray_last(da), 1498);
+
+        // Both ends still grow after shrinking
+        DynamicArray_push_front(da, -1);
+        DynamicArray_push(da, 1499);
+        ASSERT_EQ(DynamicArray_size(da), 1501);
+        ASSERT_EQ(DynamicArray_get(da, 0), -1);
+        ASSERT_EQ(DynamicArray_get(da, 1500), 1499);
+
+        while (DynamicArray_size(da) > 0) {
+            DynamicArray_pop(da);
+        }
+        DynamicArray_shrink(da);
+        ASSERT_EQ(DynamicArray_capacity(da), 1);
+        DynamicArray_push(da, X);
+        ASSERT_EQ(DynamicArray_get(da, 0), X);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, CopyAndConcat) {
+        DynamicArray * a = DynamicArray_range(0, 9, 1),
+                     * b = DynamicArray_new();
+        for (int i = 0; i < 30; i++) {
+            DynamicArray_push_front(b, i);
+        }
+        DynamicArray * c = DynamicArray_copy(a),
+                     * d = DynamicArray_concat(a, b);
+        ASSERT_EQ(DynamicArray_size(c), 10);
+        ASSERT_EQ(DynamicArray_size(d), 40);
+        for (int i = 0; i < 10; i++) {
+            ASSERT_EQ(DynamicArray_get(c, i), i);
+            ASSERT_EQ(DynamicArray_get(d, i), i);
+        }
+        for (int i = 0; i < 30; i++) {
+            ASSERT_EQ(DynamicArray_get(d, 10 + i), 29 - i);
+        }
+        DynamicArray_destroy(a);
+        DynamicArray_destroy(b);
+        DynamicArray_destroy(c);
+        DynamicArray_destroy(d);
+    }
+
+    // Quantile of sorted values, interpolating between neighbouring ranks
+    double sorted_quantile(const std::vector<double>& sorted, double q) {
+        double h = (sorted.size() - 1) * q;
+        size_t low = (size_t) h;
+        return low + 1 < sorted.size() ? sorted[low] + (h - low) * (sorted[low + 1] - sorted[low]) : sorted[low];
+    }
+
+    TEST(DynamicArray, Median) {
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_push(da, 3);
+        ASSERT_EQ(DynamicArray_median(da), 3);
+        DynamicArray_push(da, 1);
+        ASSERT_EQ(DynamicArray_median(da), 2);
+        DynamicArray_push(da, 7);
+        ASSERT_EQ(DynamicArray_median(da), 3);
+        ASSERT_EQ(DynamicArray_get(da, 0), 3);   // the array itself is not reordered
+        ASSERT_EQ(DynamicArray_quantile(da, 0), 1);
+        ASSERT_EQ(DynamicArray_quantile(da, 1), 7);
+        ASSERT_EQ(DynamicArray_quantile(da, 0.75), 5);
+        DynamicArray_destroy(da);
+    }
+
+    TEST(DynamicArray, QuantilesMatchSorting) {
+        const double q[] = {0, 0.001, 0.1, 0.25, 0.5, 0.5, 0.9, 0.999, 1};
+        const int m = sizeof(q) / sizeof(q[0]);
+        srand(520);
+        for (int shape = 0; shape < 5; shape++) {
+            for (int n : {1, 2, 7, 601, 5000, 100001}) {
+                DynamicArray * da = DynamicArray_new();
+                for (int i = 0; i < n; i++) {
+                    double x = shape == 0 ? rand() / (double) RAND_MAX   // random
+                             : shape == 1 ? i                           // sorted
+                             : shape == 2 ? n - i                       // reversed
+                             : shape == 3 ? 4.0                         // all equal
+                             : rand() % 10;                             // few values
+                    DynamicArray_push(da, x);
+                }
+                std::vector<double> sorted(da->buffer + da->origin, da->buffer + da->end);
+                std::sort(sorted.begin(), sorted.end());
+
+                double out[m];
+                DynamicArray_quantiles(da, q, m, out);
+                double * scratch = da->scratch;
+                for (int i = 0; i < m; i++) {
+                    ASSERT_DOUBLE_EQ(out[i], sorted_quantile(sorted, q[i])) << "shape " << shape << " n " << n << " q " << q[i];
+                    ASSERT_DOUBLE_EQ(DynamicArray_quantile(da, q[i]), out[i]);
+                }
+                ASSERT_EQ(da->scratch, scratch);   // reused, not reallocated
+                ASSERT_DOUBLE_EQ(DynamicArray_median(da), sorted_quantile(sorted, 0.5));
+                DynamicArray_destroy(da);
+            }
+        }
+    }
+
+    TEST(DynamicArray, Stats) {
+        DynamicArrayStats s;
+        DynamicArray * da = DynamicArray_new();
+        DynamicArray_stats(da, &s);
+        ASSERT_EQ(s.count, 0);
+        ASSERT_EQ(s.sum, 0);
+        ASSERT_TRUE(isnan(s.mean) && isnan(s.variance) && isnan(s.min) && isnan(s.max));
+
+        // Sizes around the lane and block widths, values far from zero so a
+        // sum-of-squares variance would cancel badly
+        srand(50);
+        for (int n : {1, 7, 8, 9, 1023, 1024, 1025, 5000, 100003}) {
+            while (DynamicArray_size(da) > 0) {
+                DynamicArray_pop(da);
+            }
+            DynamicArray_push_front(da, 0);   // origin not aligned to anything
+            DynamicArray_pop_front(da);
+            for (int i = 0; i < n; i++) {
+                DynamicArray_push(da, 1e9 + rand() / (double) RAND_MAX - (i == n / 3 ? 5 : 0) + (i == n / 2 ? 5 : 0));
+            }
+            long double sum = 0, squares = 0;
+            double min = DynamicArray_get(da, 0), max = min;
+            for (int i = 0; i < n; i++) {
+                double x = DynamicArray_get(da, i);
+                sum += x;
+                min = x < min ? x : min;
+                max = x > max ? x : max;
+            }
+            long double mean = sum / n;
+            for (int i = 0; i < n; i++) {
+                squares += (DynamicArray_get(da, i) - mean) * (DynamicArray_get(da, i) - mean);
+            }
+
+            DynamicArray_stats(da, &s);
+            ASSERT_EQ(s.count, n);
+            ASSERT_NEAR(s.sum, (double) sum, 1e-6 * n);
+            ASSERT_NEAR(s.mean, (double) mean, 1e-6);
+            ASSERT_NEAR(s.variance, (double) (squares / n), 1e-6 + 1e-9 * (double) (squares / n));
+            ASSERT_EQ(s.min, min);
+            ASSERT_EQ(s.max, max);
+
+            ASSERT_EQ(DynamicArray_min(da), min);
+            ASSERT_EQ(DynamicArray_max(da), max);
+            ASSERT_NEAR(DynamicArray_sum(da), (double) sum, 1e-6 * n);
+            ASSERT_NEAR(DynamicArray_mean(da), (double) mean, 1e-6);
+        }
+        DynamicArray_destroy(da);
+    }
+
+}
@@ -0,0 +1,86 @@
+// Per-element costs of Complex arithmetic and of the batch functions in
+// complex.h over arrays that fit in L1, for double and float. Uses the
+// benchmark harness from hw_6; run with --help for its options.
+// complex_mac and complex_gemm measure the multiply-accumulate and matrix
+// kernels in more detail.
+
+#include <vector>
+#include "benchmark.h"
+#include "complex.h"
+
+const std::size_t N = 1024;
+
+template <typename C>
+std::vector<C> values(int seed) {
+    std::vector<C> v(N);
+    for (std::size_t i = 0; i < N; i++) {
+        v[i] = C(0.5 + (i + seed) % 7, 0.25 - (i * seed) % 3);
+    }
+    return v;
+}
+
+// c[i] = a[i] op b[i] over the whole array per iteration
+template <typename C, typename Op>
+void elementwise(BenchmarkState& state, Op op) {
+    std::vector<C> a = values<C>(1), b = values<C>(2), c(N);
+    state.set_items_per_iteration(N);
+    for (auto _ : state) {
+        for (std::size_t i = 0; i < N; i++) {
+            c[i] = op(a[i], b[i]);
+        }
+        clobber_memory();
+    }
+    do_not_optimize(c[N / 2]);
+}
+
+template <typename C>
+void add(BenchmarkState& state) {
+    elementwise<C>(state, [](const C& x, const C& y) { return x + y; });
+}
+
+template <typename C>
+void multiply(BenchmarkState& state) {
+    elementwise<C>(state, [](const C& x, const C& y) { return x * y; });
+}
+
+template <typename C>
+void divide(BenchmarkState& state) {
+    elementwise<C>(state, [](const C& x, const C& y) { return x / y; });
+}
+
+// One of the scalar batch functions, norm_n() and the magnitudes
+template <typename S, void (*F)(const TypedComplex<S>*, S*, std::size_t)>
+void batch(BenchmarkState& state) {
+    std::vector<TypedComplex<S>> z = values<TypedComplex<S>>(3);
+    std::vector<S> out(N);
+    state.set_items_per_iteration(N);
+    for (auto _ : state) {
+        F(z.data(), out.data(), N);
+        clobber_memory();
+    }
+    do_not_optimize(out[N / 2]);
+}
+
+template <typename S>
+void threshold(BenchmarkState& state) {
+    std::vector<TypedComplex<S>> z = values<TypedComplex<S>>(4);
+    state.set_items_per_iteration(N);
+    for (auto _ : state) {
+        std::size_t count = threshold_n(z.data(), S(3), (bool*) nullptr, N);
+        do_not_optimize(count);
+    }
+}
+
+BENCHMARK_NAMED("add/Complex", add<Complex>);
+BENCHMARK_NAMED("add/ComplexFloat", add<ComplexFloat>);
+BENCHMARK_NAMED("multiply/Complex", multiply<Complex>);
+BENCHMARK_NAMED("multiply/ComplexFloat", multiply<ComplexFloat>);
+BENCHMARK_NAMED("divide/Complex", divide<Complex>);
+BENCHMARK_NAMED("norm_n/Complex", (batch<double, norm_n<double>>));
+BENCHMARK_NAMED("magnitude_n/Complex", (batch<double, magnitude_n<double>>));
+BENCHMARK_NAMED("safe_magnitude_n/Complex", (batch<double, safe_magnitude_n<double>>));
+BENCHMARK_NAMED("approx_magnitude_n/Complex", (batch<double, approx_magnitude_n<double>>));
+BENCHMARK_NAMED("magnitude_n/ComplexFloat", (batch<float, magnitude_n<float>>));
+BENCHMARK_NAMED("threshold_n/Complex", threshold<double>);
+
+BENCHMARK_MAIN();
@@ -0,0 +1,58 @@
+// Compares GFLOP/s of the naive triple loop against the cache-blocked
+// complex matrix product, single threaded and with one thread per core.
+// A complex multiply-add counts as 8 floating point operations.
+//
+// Usage: bin/bench_complex_gemm [max_size]
+
+#include <chrono>
+#include <stdio.h>
+#include <stdlib.h>
+#include <thread>
+#include "complex_matrix.h"
+
+static void fill(ComplexMatrix& m, double seed) {
+    for (int i = 0; i < m.rows(); i++) {
+        for (int j = 0; j < m.cols(); j++) {
+            m(i, j) = Complex(seed * ((i + 2 * j) % 11) - 3, 0.5 - ((3 * i + j) % 7) / seed);
+        }
+    }
+}
+
+template <typename Kernel>
+static double gflops(int n, Kernel kernel) {
+    double flops = 8.0 * n * n * n,
+           seconds = 0;
+    int repeats = 0;
+    // Repeat until at least a quarter second has been measured
+    while (seconds < 0.25) {
+        auto start = std::chrono::steady_clock::now();
+        kernel();
+        auto stop = std::chrono::steady_clock::now();
+        seconds += std::chrono::duration<double>(stop - start).count();
+        repeats++;
+    }
+    return flops * repeats / seconds / 1e9;
+}
+
+int main(int argc, char **argv) {
+    int max_size = argc > 1 ? atoi(argv[1]) : 1024;
+    int cores = std::max(1u, std::thread::hardware_concurrency());
+
+    printf("%6s %12s %12s %12s  (%d threads)\n", "n", "naive", "blocked", "threaded", cores);
+    for (int n = 64; n <= max_size; n *= 2) {
+        ComplexMatrix a(n, n), b(n, n), c(n, n);
+        fill(a, 1.25);
+        fill(b, -0.5);
+
+        double naive = n <= 512 ? gflops(n, [&]() { multiply_naive(a, b, c); }) : 0.0;
+        double blocked = gflops(n, [&]() { multiply(a, b, c, 1); });
+        double threaded = gflops(n, [&]() { multiply(a, b, c, cores); });
+
+        if (naive > 0) {
+            printf("%6d %12.2f %12.2f %12.2f  GFLOP/s\n", n, naive, blocked, threaded);
+        } else {
+            printf("%6d %12s %12.2f %12.2f  GFLOP/s\n", n, "-", blocked, threaded);
+        }
+    }
+    return 0;
+}
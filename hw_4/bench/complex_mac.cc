@@ -0,0 +1,61 @@
+// Times the complex multiply-accumulate loop c[i] += a[i] * b[i].
+//
+// Build with `make bench` and run bin/bench_complex_mac. The scalar variant
+// is compiled with vectorization disabled, so the ratio between it and the
+// Complex rows is what auto-vectorization buys. `make vecreport` prints the
+// compiler's own account of which loops were vectorized.
+
+#include <chrono>
+#include <complex>
+#include <stdio.h>
+#include <vector>
+#include "complex.h"
+
+#if defined(__GNUC__) && !defined(__clang__)
+#define NO_VECTORIZE __attribute__((optimize("no-tree-vectorize")))
+#else
+#define NO_VECTORIZE
+#endif
+
+template <typename C>
+__attribute__((noinline)) void mac(const C* a, const C* b, C* c, int n) {
+    for (int i = 0; i < n; i++) {
+        c[i] += a[i] * b[i];
+    }
+}
+
+template <typename C>
+__attribute__((noinline)) NO_VECTORIZE void mac_scalar(const C* a, const C* b, C* c, int n) {
+    for (int i = 0; i < n; i++) {
+        c[i] += a[i] * b[i];
+    }
+}
+
+template <typename C, typename Kernel>
+void run(const char* name, Kernel kernel) {
+    const int n = 4096, repeats = 20000;
+    std::vector<C> a(n), b(n), c(n);
+    for (int i = 0; i < n; i++) {
+        a[i] = C(0.5 + i % 7, 0.25 - i % 3);
+        b[i] = C(1.0 / (1 + i % 5), 0.125 * (i % 4));
+    }
+
+    kernel(a.data(), b.data(), c.data(), n);  // warm up
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < repeats; r++) {
+        kernel(a.data(), b.data(), c.data(), n);
+    }
+    auto stop = std::chrono::steady_clock::now();
+
+    double ns = std::chrono::duration<double, std::nano>(stop - start).count();
+    printf("%-28s %8.3f ns/MAC   (checksum %g)\n", name, ns / ((double) n * repeats),
+           (double) c[n / 2].real());
+}
+
+int main() {
+    run<Complex>("Complex scalar", mac_scalar<Complex>);
+    run<Complex>("Complex", mac<Complex>);
+    run<ComplexFloat>("ComplexFloat", mac<ComplexFloat>);
+    run<std::complex<double>>("std::complex<double>", mac<std::complex<double>>);
+    return 0;
+}
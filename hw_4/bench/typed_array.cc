@@ -0,0 +1,102 @@
+// Costs of the basic TypedArray operations: appending at either end,
+// popping, indexed reads, copying and concatenation. Uses the benchmark
+// harness from hw_6; run with --help for its options.
+
+#include <string>
+#include "benchmark.h"
+#include "complex.h"
+#include "typed_array.h"
+
+const int SIZE = 10000;
+
+template <typename T>
+TypedArray<T> filled(int n) {
+    TypedArray<T> a;
+    for (int i = 0; i < n; i++) {
+        a.push(T(i));
+    }
+    return a;
+}
+
+// Builds an array of SIZE elements with push() per iteration
+template <typename T>
+void push(BenchmarkState& state) {
+    state.set_items_per_iteration(SIZE);
+    for (auto _ : state) {
+        TypedArray<T> a;
+        for (int i = 0; i < SIZE; i++) {
+            a.push(T(i));
+        }
+        do_not_optimize(a);
+    }
+}
+
+// The same with push_front()
+template <typename T>
+void push_front(BenchmarkState& state) {
+    state.set_items_per_iteration(SIZE);
+    for (auto _ : state) {
+        TypedArray<T> a;
+        for (int i = 0; i < SIZE; i++) {
+            a.push_front(T(i));
+        }
+        do_not_optimize(a);
+    }
+}
+
+// Empties a SIZE element array with pop(); refilling is not timed
+template <typename T>
+void pop(BenchmarkState& state) {
+    state.set_items_per_iteration(SIZE);
+    for (auto _ : state) {
+        state.pause_timing();
+        TypedArray<T> a = filled<T>(SIZE);
+        state.resume_timing();
+        for (int i = 0; i < SIZE; i++) {
+            T x = a.pop();
+            do_not_optimize(x);
+        }
+    }
+}
+
+// Reads every element of a SIZE element array with safe_get()
+template <typename T>
+void safe_get(BenchmarkState& state) {
+    TypedArray<T> a = filled<T>(SIZE);
+    state.set_items_per_iteration(SIZE);
+    for (auto _ : state) {
+        for (int i = 0; i < SIZE; i++) {
+            do_not_optimize(a.safe_get(i));
+        }
+    }
+}
+
+template <typename T>
+void copy(BenchmarkState& state) {
+    TypedArray<T> a = filled<T>(SIZE);
+    state.set_items_per_iteration(SIZE);
+    for (auto _ : state) {
+        TypedArray<T> b(a);
+        do_not_optimize(b);
+    }
+}
+
+template <typename T>
+void concat(BenchmarkState& state) {
+    TypedArray<T> a = filled<T>(SIZE / 2), b = filled<T>(SIZE / 2);
+    state.set_items_per_iteration(SIZE);
+    for (auto _ : state) {
+        TypedArray<T> c = a + b;
+        do_not_optimize(c);
+    }
+}
+
+BENCHMARK_NAMED("push/double", push<double>);
+BENCHMARK_NAMED("push/Complex", push<Complex>);
+BENCHMARK_NAMED("push_front/double", push_front<double>);
+BENCHMARK_NAMED("pop/double", pop<double>);
+BENCHMARK_NAMED("safe_get/double", safe_get<double>);
+BENCHMARK_NAMED("copy/double", copy<double>);
+BENCHMARK_NAMED("concat/double", concat<double>);
+
+BENCHMARK_MAIN();
@@ -1,25 +1,167 @@
 #ifndef COMPLEX
 #define COMPLEX
 
+#include <cmath>
+#include <cstddef>
 #include <iostream>
 
-class Complex {
+// Complex numbers over a floating point scalar type.
+//
+// Everything is defined inline and, except for the square roots in
+// magnitude() and safe_magnitude(), constexpr, so loops over arrays of complex values can be
+// inlined and vectorized by the compiler without link time optimization.
+// The layout is exactly two scalars (real then imaginary part).
+template <typename ScalarType>
+class TypedComplex {
 public:
-    Complex(double x, double y) : re(x), im(y) {}
-    Complex(double a) : re(a), im(0) {}
+    constexpr TypedComplex() : re(0), im(0) {}
+    constexpr TypedComplex(ScalarType x, ScalarType y) : re(x), im(y) {}
+    constexpr TypedComplex(ScalarType a) : re(a), im(0) {}
 
-    double magnitude() const;
-    double real() const;         // Returns the real part
-    double imaginary() const;    // Returns the imaginary part
-    Complex conjugate() const;   // Returns the complex conjugate
+    // Returns the magnitude (absolute value) of the complex number
+    ScalarType magnitude() const { return std::sqrt(norm()); }
 
-    // Operator Overloads
-    Complex operator+(const Complex& other) const;
-    Complex operator*(const Complex& other) const;
-    bool operator==(const Complex& other) const;
+    // Returns the squared magnitude, which needs no square root. Prefer it
+    // when magnitudes are only compared or thresholded.
+    constexpr ScalarType norm() const { return re * re + im * im; }
+
+    // Magnitude via hypot, which does not overflow or underflow in the
+    // intermediate squares (magnitude() of 1e200+1e200i is inf). Slower.
+    ScalarType safe_magnitude() const { return std::hypot(re, im); }
+
+    // Alpha max plus beta min estimate of the magnitude, with no square root.
+    // The coefficients minimize the worst case: the relative error is at most
+    // 3.96% in either direction.
+    constexpr ScalarType approx_magnitude() const {
+        ScalarType a = re < 0 ? -re : re,
+                   b = im < 0 ? -im : im;
+        return a > b ? ScalarType(0.96043387010342) * a + ScalarType(0.39782473475013) * b
+                     : ScalarType(0.96043387010342) * b + ScalarType(0.39782473475013) * a;
+    }
+
+    constexpr ScalarType real() const { return re; }          // Returns the real part
+    constexpr ScalarType imaginary() const { return im; }     // Returns the imaginary part
+    constexpr TypedComplex conjugate() const {                // Returns the complex conjugate
+        return TypedComplex(re, -im);
+    }
+
+    // Compound assignment
+    constexpr TypedComplex& operator+=(const TypedComplex& other) {
+        re += other.re;
+        im += other.im;
+        return *this;
+    }
+
+    constexpr TypedComplex& operator-=(const TypedComplex& other) {
+        re -= other.re;
+        im -= other.im;
+        return *this;
+    }
+
+    constexpr TypedComplex& operator*=(const TypedComplex& other) {
+        ScalarType r = re * other.re - im * other.im;
+        im = re * other.im + im * other.re;
+        re = r;
+        return *this;
+    }
+
+    // Textbook division; the divisor's squared magnitude must not overflow
+    constexpr TypedComplex& operator/=(const TypedComplex& other) {
+        ScalarType d = other.norm();
+        ScalarType r = (re * other.re + im * other.im) / d;
+        im = (im * other.re - re * other.im) / d;
+        re = r;
+        return *this;
+    }
+
+    // Operator Overloads. These are friends rather than members so a scalar
+    // on either side converts implicitly, e.g. 2.0 * z.
+    friend constexpr TypedComplex operator+(TypedComplex a, const TypedComplex& b) { return a += b; }
+    friend constexpr TypedComplex operator-(TypedComplex a, const TypedComplex& b) { return a -= b; }
+    friend constexpr TypedComplex operator*(TypedComplex a, const TypedComplex& b) { return a *= b; }
+    friend constexpr TypedComplex operator/(TypedComplex a, const TypedComplex& b) { return a /= b; }
+
+    // Real scaling, cheaper than promoting the scalar to a complex number
+    friend constexpr TypedComplex operator*(const TypedComplex& a, ScalarType s) {
+        return TypedComplex(a.re * s, a.im * s);
+    }
+    friend constexpr TypedComplex operator*(ScalarType s, const TypedComplex& a) {
+        return TypedComplex(a.re * s, a.im * s);
+    }
+    friend constexpr TypedComplex operator/(const TypedComplex& a, ScalarType s) {
+        return TypedComplex(a.re / s, a.im / s);
+    }
+
+    friend constexpr TypedComplex operator-(const TypedComplex& a) {
+        return TypedComplex(-a.re, -a.im);
+    }
+
+    friend constexpr bool operator==(const TypedComplex& a, const TypedComplex& b) {
+        return (a.re == b.re) && (a.im == b.im);
+    }
+
+    friend constexpr bool operator!=(const TypedComplex& a, const TypedComplex& b) {
+        return !(a == b);
+    }
 
 private:
-    double re, im;
+    ScalarType re, im;
 };
 
+template <typename ScalarType>
+std::ostream &operator<<(std::ostream &os, const TypedComplex<ScalarType> &z) {
+    return os << '(' << z.real() << ',' << z.imaginary() << ')';
+}
+
+// Batch versions over arrays of n complex numbers. These are plain loops
+// over inline functions, so they vectorize when optimizations are on.
+
+template <typename ScalarType>
+void norm_n(const TypedComplex<ScalarType>* z, ScalarType* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = z[i].norm();
+    }
+}
+
+template <typename ScalarType>
+void magnitude_n(const TypedComplex<ScalarType>* z, ScalarType* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = z[i].magnitude();
+    }
+}
+
+template <typename ScalarType>
+void safe_magnitude_n(const TypedComplex<ScalarType>* z, ScalarType* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = z[i].safe_magnitude();
+    }
+}
+
+template <typename ScalarType>
+void approx_magnitude_n(const TypedComplex<ScalarType>* z, ScalarType* out, std::size_t n) {
+    for (std::size_t i = 0; i < n; i++) {
+        out[i] = z[i].approx_magnitude();
+    }
+}
+
+// Marks the elements whose magnitude exceeds threshold and returns how many
+// there are. Compares squared magnitudes, so no square roots are taken. The
+// mask may be null when only the count is wanted.
+template <typename ScalarType>
+std::size_t threshold_n(const TypedComplex<ScalarType>* z, ScalarType threshold, bool* mask, std::size_t n) {
+    const ScalarType limit = threshold * threshold;
+    std::size_t count = 0;
+    for (std::size_t i = 0; i < n; i++) {
+        bool above = z[i].norm() > limit;
+        if (mask) {
+            mask[i] = above;
+        }
+        count += above;
+    }
+    return count;
+}
+
+typedef TypedComplex<double> Complex;
+typedef TypedComplex<float> ComplexFloat;
+
 #endif
@@ -0,0 +1,219 @@
+#ifndef COMPLEX_MATRIX_H
+#define COMPLEX_MATRIX_H
+
+#include <algorithm>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "complex.h"
+
+// Dense row-major matrices of complex numbers, with matrix-matrix (GEMM)
+// and matrix-vector (GEMV) products. Vectors are plain std::vectors.
+template <typename ScalarType>
+class TypedComplexMatrix {
+
+public:
+
+    typedef TypedComplex<ScalarType> Element;
+
+    TypedComplexMatrix(int rows, int cols);
+
+    // Getters
+    int rows() const { return n_rows; }
+    int cols() const { return n_cols; }
+
+    Element &operator()(int row, int col) { return elements[(size_t) row * n_cols + col]; }
+    const Element &operator()(int row, int col) const { return elements[(size_t) row * n_cols + col]; }
+
+    Element *data() { return elements.data(); }
+    const Element *data() const { return elements.data(); }
+
+    bool operator==(const TypedComplexMatrix& other) const {
+        return n_rows == other.n_rows && n_cols == other.n_cols && elements == other.elements;
+    }
+
+private:
+
+    int n_rows,
+        n_cols;
+
+    std::vector<Element> elements;
+
+};
+
+typedef TypedComplexMatrix<double> ComplexMatrix;
+typedef std::vector<Complex> ComplexVector;
+
+template <typename ScalarType>
+TypedComplexMatrix<ScalarType>::TypedComplexMatrix(int rows, int cols) :
+    n_rows(rows), n_cols(cols) {
+    if (rows < 0 || cols < 0) {
+        throw std::invalid_argument("Matrix dimensions must not be negative");
+    }
+    elements.resize((size_t) rows * cols);
+}
+
+namespace complex_matrix_detail {
+
+    // Block sizes for the tiled product. B is cut into KC x NC panels
+    // (256 KB for complex doubles) that each stay in L2 while every row of
+    // C in a thread's range is accumulated against them.
+    const int KC = 128,
+              NC = 128;
+
+    inline int thread_count(int threads, int rows) {
+        if (threads <= 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        return std::max(1, std::min(threads, rows));
+    }
+
+    // Runs body(first_row, last_row) over contiguous row ranges, one per thread
+    template <typename Body>
+    void for_row_blocks(int rows, int threads, Body body) {
+        threads = thread_count(threads, rows);
+        if (threads == 1) {
+            body(0, rows);
+            return;
+        }
+        std::vector<std::thread> workers;
+        int chunk = (rows + threads - 1) / threads;
+        for (int t = 0; t < threads; t++) {
+            int first = t * chunk,
+                last = std::min(rows, first + chunk);
+            if (first < last) {
+                workers.push_back(std::thread(body, first, last));
+            }
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    // Copies B into its panels, each one contiguous with rows of nc
+    // elements, in the order blocked_rows() visits them: by column block,
+    // then by row block. Done once and shared by every thread.
+    template <typename ScalarType>
+    std::vector<TypedComplex<ScalarType>> pack_panels(const TypedComplexMatrix<ScalarType>& b) {
+        std::vector<TypedComplex<ScalarType>> packed((size_t) b.rows() * b.cols());
+        TypedComplex<ScalarType> * out = packed.data();
+        for (int jc = 0; jc < b.cols(); jc += NC) {
+            int nc = std::min(NC, b.cols() - jc);
+            for (int pc = 0; pc < b.rows(); pc += KC) {
+                int kc = std::min(KC, b.rows() - pc);
+                for (int p = 0; p < kc; p++, out += nc) {
+                    std::copy(&b(pc + p, jc), &b(pc + p, jc) + nc, out);
+                }
+            }
+        }
+        return packed;
+    }
+
+    // C[first..last) = A[first..last) * B, with B packed by pack_panels()
+    template <typename ScalarType>
+    void blocked_rows(const TypedComplexMatrix<ScalarType>& a, const std::vector<TypedComplex<ScalarType>>& packed,
+                      TypedComplexMatrix<ScalarType>& c, int first, int last) {
+        typedef TypedComplex<ScalarType> Element;
+        int k_total = a.cols(),
+            n_total = c.cols();
+        const Element * panel = packed.data();
+
+        std::fill(c.data() + (size_t) first * n_total, c.data() + (size_t) last * n_total, Element());
+
+        for (int jc = 0; jc < n_total; jc += NC) {
+            int nc = std::min(NC, n_total - jc);
+            for (int pc = 0; pc < k_total; pc += KC) {
+                int kc = std::min(KC, k_total - pc);
+                for (int i = first; i < last; i++) {
+                    Element * c_row = &c(i, jc);
+                    const Element * a_row = &a(i, pc);
+                    for (int p = 0; p < kc; p++) {
+                        const Element a_ip = a_row[p];
+                        const Element * b_row = panel + (size_t) p * nc;
+                        for (int j = 0; j < nc; j++) {
+                            c_row[j] += a_ip * b_row[j];
+                        }
+                    }
+                }
+                panel += (size_t) kc * nc;
+            }
+        }
+    }
+
+}
+
+// Reference triple loop: c = a * b
+template <typename ScalarType>
+void multiply_naive(const TypedComplexMatrix<ScalarType>& a, const TypedComplexMatrix<ScalarType>& b,
+                    TypedComplexMatrix<ScalarType>& c) {
+    if (a.cols() != b.rows() || c.rows() != a.rows() || c.cols() != b.cols()) {
+        throw std::invalid_argument("Matrix dimensions do not agree");
+    }
+    for (int i = 0; i < a.rows(); i++) {
+        for (int j = 0; j < b.cols(); j++) {
+            TypedComplex<ScalarType> sum;
+            for (int k = 0; k < a.cols(); k++) {
+                sum += a(i, k) * b(k, j);
+            }
+            c(i, j) = sum;
+        }
+    }
+}
+
+// Cache-blocked product c = a * b. Rows of c are split across the given
+// number of threads; zero or less means one per hardware thread.
+template <typename ScalarType>
+void multiply(const TypedComplexMatrix<ScalarType>& a, const TypedComplexMatrix<ScalarType>& b,
+              TypedComplexMatrix<ScalarType>& c, int threads = 1) {
+    if (a.cols() != b.rows() || c.rows() != a.rows() || c.cols() != b.cols()) {
+        throw std::invalid_argument("Matrix dimensions do not agree");
+    }
+    if (&c == &a || &c == &b) {
+        throw std::invalid_argument("Product must not overwrite an operand");
+    }
+    std::vector<TypedComplex<ScalarType>> packed = complex_matrix_detail::pack_panels(b);
+    complex_matrix_detail::for_row_blocks(a.rows(), threads, [&](int first, int last) {
+        complex_matrix_detail::blocked_rows(a, packed, c, first, last);
+    });
+}
+
+// Matrix-vector product y = a * x, rows split across threads as above
+template <typename ScalarType>
+void multiply(const TypedComplexMatrix<ScalarType>& a, const std::vector<TypedComplex<ScalarType>>& x,
+              std::vector<TypedComplex<ScalarType>>& y, int threads = 1) {
+    if ((int) x.size() != a.cols()) {
+        throw std::invalid_argument("Matrix and vector dimensions do not agree");
+    }
+    if (&x == &y) {
+        throw std::invalid_argument("Product must not overwrite an operand");
+    }
+    y.resize(a.rows());
+    complex_matrix_detail::for_row_blocks(a.rows(), threads, [&](int first, int last) {
+        for (int i = first; i < last; i++) {
+            const TypedComplex<ScalarType> * row = a.data() + (size_t) i * a.cols();
+            TypedComplex<ScalarType> sum;
+            for (int j = 0; j < a.cols(); j++) {
+                sum += row[j] * x[j];
+            }
+            y[i] = sum;
+        }
+    });
+}
+
+template <typename ScalarType>
+TypedComplexMatrix<ScalarType> operator*(const TypedComplexMatrix<ScalarType>& a,
+                                         const TypedComplexMatrix<ScalarType>& b) {
+    TypedComplexMatrix<ScalarType> c(a.rows(), b.cols());
+    multiply(a, b, c);
+    return c;
+}
+
+template <typename ScalarType>
+std::vector<TypedComplex<ScalarType>> operator*(const TypedComplexMatrix<ScalarType>& a,
+                                                const std::vector<TypedComplex<ScalarType>>& x) {
+    std::vector<TypedComplex<ScalarType>> y;
+    multiply(a, x, y);
+    return y;
+}
+
+#endif // COMPLEX_MATRIX_H
@@ -0,0 +1,161 @@
+#include <math.h>
+#include <stdexcept>
+#include "fft.h"
+
+namespace {
+
+    bool is_power_of_two(int n) {
+        return n > 0 && (n & (n - 1)) == 0;
+    }
+
+}
+
+// Builds the tables for a transform of length n
+FFT::FFT(int n) : n(n), power_of_two(is_power_of_two(n)) {
+    if (n < 1) {
+        throw std::invalid_argument("FFT size must be positive");
+    }
+
+    if (power_of_two) {
+        for (int k = 0; k < n / 2; k++) {
+            double angle = -2.0 * M_PI * k / n;
+            twiddles.push_back(Complex(cos(angle), sin(angle)));
+        }
+
+        int bits = 0;
+        while ((1 << bits) < n) {
+            bits++;
+        }
+        bit_reverse.resize(n);
+        for (int i = 0; i < n; i++) {
+            int reversed = 0;
+            for (int b = 0; b < bits; b++) {
+                if (i & (1 << b)) {
+                    reversed |= 1 << (bits - 1 - b);
+                }
+            }
+            bit_reverse[i] = reversed;
+        }
+        return;
+    }
+
+    // Bluestein: express the length-n DFT as a circular convolution of
+    // length m >= 2n-1, which a power-of-two plan can evaluate.
+    int m = 1;
+    while (m < 2 * n - 1) {
+        m <<= 1;
+    }
+    convolution.reset(new FFT(m));
+
+    for (int k = 0; k < n; k++) {
+        // k^2 mod 2n keeps the angle small so large k do not lose precision
+        long long k2 = (long long) k * k % (2LL * n);
+        double angle = -M_PI * k2 / n;
+        chirp.push_back(Complex(cos(angle), sin(angle)));
+    }
+
+    chirp_spectrum.assign(m, Complex());
+    chirp_spectrum[0] = chirp[0].conjugate();
+    for (int k = 1; k < n; k++) {
+        chirp_spectrum[k] = chirp[k].conjugate();
+        chirp_spectrum[m - k] = chirp[k].conjugate();
+    }
+    convolution->forward(chirp_spectrum);
+
+    work.assign(m, Complex());
+}
+
+FFT::~FFT() {}
+
+int FFT::size() const {
+    return n;
+}
+
+void FFT::forward(std::vector<Complex>& data) {
+    check_size(data);
+    forward(data.data());
+}
+
+void FFT::inverse(std::vector<Complex>& data) {
+    check_size(data);
+    inverse(data.data());
+}
+
+void FFT::forward(Complex* data) {
+    if (power_of_two) {
+        radix2(data, false);
+    } else {
+        bluestein(data, false);
+    }
+}
+
+void FFT::inverse(Complex* data) {
+    if (power_of_two) {
+        radix2(data, true);
+    } else {
+        bluestein(data, true);
+    }
+    double s = 1.0 / n;
+    for (int i = 0; i < n; i++) {
+        data[i] = data[i] * s;
+    }
+}
+
+// Iterative Cooley-Tukey transform. The inverse direction uses conjugated
+// twiddles and leaves scaling to the caller.
+void FFT::radix2(Complex* data, bool invert) {
+    for (int i = 0; i < n; i++) {
+        int j = bit_reverse[i];
+        if (i < j) {
+            Complex temp = data[i];
+            data[i] = data[j];
+            data[j] = temp;
+        }
+    }
+
+    for (int len = 2; len <= n; len <<= 1) {
+        int half = len / 2,
+            step = n / len;
+        for (int start = 0; start < n; start += len) {
+            for (int j = 0; j < half; j++) {
+                Complex w = invert ? twiddles[j * step].conjugate() : twiddles[j * step];
+                Complex u = data[start + j];
+                Complex v = data[start + j + half] * w;
+                data[start + j] = u + v;
+                data[start + j + half] = u - v;
+            }
+        }
+    }
+}
+
+// Chirp-z transform: X[k] = c[k] * sum (x[j] c[j]) conj(c[k-j]) with
+// c[k] = e^{-pi i k^2/n}. The inverse is obtained by conjugating the input
+// and output of the forward transform, again without scaling.
+void FFT::bluestein(Complex* data, bool invert) {
+    int m = convolution->size();
+
+    for (int k = 0; k < n; k++) {
+        Complex x = invert ? data[k].conjugate() : data[k];
+        work[k] = x * chirp[k];
+    }
+    for (int k = n; k < m; k++) {
+        work[k] = Complex();
+    }
+
+    convolution->forward(work.data());
+    for (int k = 0; k < m; k++) {
+        work[k] *= chirp_spectrum[k];
+    }
+    convolution->inverse(work.data());
+
+    for (int k = 0; k < n; k++) {
+        Complex y = work[k] * chirp[k];
+        data[k] = invert ? y.conjugate() : y;
+    }
+}
+
+void FFT::check_size(const std::vector<Complex>& data) const {
+    if ((int) data.size() != n) {
+        throw std::invalid_argument("Data length does not match FFT size");
+    }
+}
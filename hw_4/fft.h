@@ -0,0 +1,52 @@
+#ifndef FFT_H
+#define FFT_H
+
+#include <memory>
+#include <vector>
+#include "complex.h"
+
+// A reusable plan for discrete Fourier transforms of one fixed size.
+//
+// Twiddle factors and the bit-reversal permutation are computed once in the
+// constructor, along with every scratch buffer the transform needs, so calling
+// forward() or inverse() repeatedly on data of the planned size allocates
+// nothing. Power-of-two sizes use an iterative radix-2 transform; any other
+// size is handled with Bluestein's algorithm on top of a power-of-two plan.
+//
+// A plan owns mutable scratch space, so one plan must not be used from
+// several threads at the same time.
+class FFT {
+public:
+    FFT(int n);
+    ~FFT();
+
+    int size() const;
+
+    // In-place transforms. forward computes X[k] = sum x[j] e^{-2 pi i jk/n};
+    // inverse applies the opposite sign and divides by n.
+    void forward(std::vector<Complex>& data);
+    void inverse(std::vector<Complex>& data);
+
+    void forward(Complex* data);
+    void inverse(Complex* data);
+
+private:
+    int n;
+    bool power_of_two;
+
+    // Radix-2 tables (power-of-two sizes only)
+    std::vector<Complex> twiddles;   // e^{-2 pi i k/n}, k < n/2
+    std::vector<int> bit_reverse;    // swap partner for each index
+
+    // Bluestein tables (all other sizes)
+    std::unique_ptr<FFT> convolution;   // power-of-two plan of size >= 2n-1
+    std::vector<Complex> chirp;         // e^{-pi i k^2/n}
+    std::vector<Complex> chirp_spectrum;
+    std::vector<Complex> work;
+
+    void radix2(Complex* data, bool invert);
+    void bluestein(Complex* data, bool invert);
+    void check_size(const std::vector<Complex>& data) const;
+};
+
+#endif // FFT_H
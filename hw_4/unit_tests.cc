@@ -3,6 +3,8 @@
 #include <assert.h>
 #include "typed_array.h"
 #include "complex.h"
+#include "fft.h"
+#include "complex_matrix.h"
 #include "gtest/gtest.h"
 
 namespace {
@@ -166,4 +168,240 @@ namespace {
         EXPECT_FALSE(a == c);
     }
 
-}
\ No newline at end of file
+    TEST(Complex, SubtractionAndNegation) {
+        Complex a(3, 4);
+        Complex b(1, -1);
+        Complex diff = a - b;
+        EXPECT_DOUBLE_EQ(diff.real(), 2.0);
+        EXPECT_DOUBLE_EQ(diff.imaginary(), 5.0);
+        EXPECT_TRUE(-a == Complex(-3, -4));
+    }
+
+    TEST(Complex, Division) {
+        Complex a(7, 1);
+        Complex b(1, -1);
+        Complex quotient = a / b;  // (7 + i) / (1 - i) = 3 + 4i
+        EXPECT_DOUBLE_EQ(quotient.real(), 3.0);
+        EXPECT_DOUBLE_EQ(quotient.imaginary(), 4.0);
+        EXPECT_TRUE(Complex(4, 2) / 2.0 == Complex(2, 1));
+    }
+
+    TEST(Complex, CompoundAssignment) {
+        Complex a(3, 4);
+        a += Complex(1, 1);
+        EXPECT_TRUE(a == Complex(4, 5));
+        a -= Complex(1, 1);
+        EXPECT_TRUE(a == Complex(3, 4));
+        a *= Complex(1, -1);
+        EXPECT_TRUE(a == Complex(7, 1));
+        a /= Complex(1, -1);
+        EXPECT_TRUE(a == Complex(3, 4));
+    }
+
+    TEST(Complex, NormAndScalars) {
+        Complex a(3, 4);
+        EXPECT_DOUBLE_EQ(a.norm(), 25.0);
+        EXPECT_TRUE(2.0 * a == Complex(6, 8));
+        EXPECT_TRUE(a * 2.0 == Complex(6, 8));
+        EXPECT_TRUE(a + 1 == Complex(4, 4));
+        EXPECT_TRUE(a != Complex(3, -4));
+    }
+
+    TEST(Complex, ConstexprAndFloat) {
+        constexpr Complex a(3, 4);
+        constexpr Complex b = a * a.conjugate() - Complex(1, 0);
+        static_assert(b.real() == 24.0 && b.imaginary() == 0.0, "constexpr arithmetic");
+        static_assert(a.norm() == 25.0, "constexpr norm");
+
+        ComplexFloat f(3.0f, 4.0f);
+        EXPECT_FLOAT_EQ(f.magnitude(), 5.0f);
+        EXPECT_EQ(sizeof(ComplexFloat), 2 * sizeof(float));
+    }
+
+    TEST(Complex, SafeMagnitudeDoesNotOverflow) {
+        Complex big(1e200, 1e200);
+        EXPECT_TRUE(std::isinf(big.magnitude()));
+        EXPECT_DOUBLE_EQ(big.safe_magnitude(), sqrt(2) * 1e200);
+        Complex tiny(3e-200, 4e-200);
+        EXPECT_DOUBLE_EQ(tiny.safe_magnitude(), 5e-200);
+    }
+
+    TEST(Complex, ApproxMagnitudeError) {
+        for (int k = 0; k < 360; k++) {
+            double angle = k * M_PI / 180.0;
+            Complex z(2.5 * cos(angle), 2.5 * sin(angle));
+            EXPECT_NEAR(z.approx_magnitude() / 2.5, 1.0, 0.0397) << "at angle " << k;
+        }
+        constexpr double zero = Complex(0, 0).approx_magnitude();
+        EXPECT_EQ(zero, 0.0);
+    }
+
+    TEST(Complex, BatchMagnitudes) {
+        Complex z[5] = {Complex(3, 4), Complex(-1, 0), Complex(0, 2), Complex(6, -8), Complex()};
+        double norms[5], mags[5], safe[5], approx[5];
+        norm_n(z, norms, 5);
+        magnitude_n(z, mags, 5);
+        safe_magnitude_n(z, safe, 5);
+        approx_magnitude_n(z, approx, 5);
+        for (int i = 0; i < 5; i++) {
+            EXPECT_DOUBLE_EQ(norms[i], z[i].norm());
+            EXPECT_DOUBLE_EQ(mags[i], z[i].magnitude());
+            EXPECT_DOUBLE_EQ(safe[i], z[i].magnitude());
+            EXPECT_DOUBLE_EQ(approx[i], z[i].approx_magnitude());
+        }
+
+        bool mask[5];
+        EXPECT_EQ(threshold_n(z, 2.0, mask, 5), 2);
+        EXPECT_TRUE(mask[0]);
+        EXPECT_FALSE(mask[1]);
+        EXPECT_FALSE(mask[2]);   // exactly 2 is not above the threshold
+        EXPECT_TRUE(mask[3]);
+        EXPECT_FALSE(mask[4]);
+        EXPECT_EQ(threshold_n(z, 0.5, (bool*) nullptr, 5), 4);
+    }
+
+    // Reference O(n^2) transform used to check the FFT plans
+    std::vector<Complex> naive_dft(const std::vector<Complex>& x) {
+        int n = x.size();
+        std::vector<Complex> result;
+        for (int k = 0; k < n; k++) {
+            double re = 0, im = 0;
+            for (int j = 0; j < n; j++) {
+                double angle = -2.0 * M_PI * ((long long) j * k % n) / n;
+                Complex term = x[j] * Complex(cos(angle), sin(angle));
+                re += term.real();
+                im += term.imaginary();
+            }
+            result.push_back(Complex(re, im));
+        }
+        return result;
+    }
+
+    std::vector<Complex> test_signal(int n) {
+        std::vector<Complex> x;
+        for (int j = 0; j < n; j++) {
+            x.push_back(Complex(sin(0.3 * j) + 0.5 * j / n, cos(1.7 * j) - 0.25));
+        }
+        return x;
+    }
+
+    void expect_close(const std::vector<Complex>& a, const std::vector<Complex>& b, double tol) {
+        ASSERT_EQ(a.size(), b.size());
+        for (size_t i = 0; i < a.size(); i++) {
+            EXPECT_NEAR(a[i].real(), b[i].real(), tol) << "at index " << i;
+            EXPECT_NEAR(a[i].imaginary(), b[i].imaginary(), tol) << "at index " << i;
+        }
+    }
+
+    TEST(FFT, PowerOfTwoMatchesNaiveDFT) {
+        for (int n : {1, 2, 4, 8, 64, 256}) {
+            std::vector<Complex> x = test_signal(n);
+            std::vector<Complex> expected = naive_dft(x);
+            FFT plan(n);
+            plan.forward(x);
+            expect_close(x, expected, 1e-9 * n);
+        }
+    }
+
+    TEST(FFT, OtherSizesMatchNaiveDFT) {
+        for (int n : {3, 5, 6, 12, 100, 127}) {
+            std::vector<Complex> x = test_signal(n);
+            std::vector<Complex> expected = naive_dft(x);
+            FFT plan(n);
+            plan.forward(x);
+            expect_close(x, expected, 1e-9 * n);
+        }
+    }
+
+    TEST(FFT, InverseRoundTrip) {
+        for (int n : {16, 30}) {
+            std::vector<Complex> original = test_signal(n);
+            std::vector<Complex> x = original;
+            FFT plan(n);
+            plan.forward(x);
+            plan.inverse(x);
+            expect_close(x, original, 1e-12 * n);
+        }
+    }
+
+    TEST(FFT, PlanIsReusable) {
+        FFT plan(20);
+        std::vector<Complex> expected = naive_dft(test_signal(20));
+        for (int i = 0; i < 3; i++) {
+            std::vector<Complex> x = test_signal(20);
+            plan.forward(x);
+            expect_close(x, expected, 1e-9 * 20);
+        }
+    }
+
+    TEST(FFT, WrongSizeThrows) {
+        FFT plan(8);
+        std::vector<Complex> x = test_signal(7);
+        EXPECT_THROW(plan.forward(x), std::invalid_argument);
+        EXPECT_THROW(FFT(0), std::invalid_argument);
+    }
+
+    ComplexMatrix test_matrix(int rows, int cols, double seed) {
+        ComplexMatrix m(rows, cols);
+        for (int i = 0; i < rows; i++) {
+            for (int j = 0; j < cols; j++) {
+                m(i, j) = Complex(seed * ((i + 2 * j) % 11) - 3, 0.5 - ((3 * i + j) % 7) / seed);
+            }
+        }
+        return m;
+    }
+
+    TEST(ComplexMatrix, SmallProduct) {
+        ComplexMatrix a(2, 2), b(2, 1);
+        a(0, 0) = Complex(1, 1);  a(0, 1) = Complex(0, 2);
+        a(1, 0) = Complex(3);     a(1, 1) = Complex(1, -1);
+        b(0, 0) = Complex(2, 0);
+        b(1, 0) = Complex(0, 1);
+        ComplexMatrix c = a * b;
+        EXPECT_TRUE(c(0, 0) == Complex(0, 2));   // (1+i)2 + (2i)(i)
+        EXPECT_TRUE(c(1, 0) == Complex(7, 1));   // 3*2 + (1-i)(i)
+    }
+
+    TEST(ComplexMatrix, BlockedMatchesNaive) {
+        // Dimensions straddle the block sizes so partial tiles are exercised
+        ComplexMatrix a = test_matrix(70, 150, 1.25),
+                      b = test_matrix(150, 133, -0.5);
+        ComplexMatrix expected(70, 133), blocked(70, 133), threaded(70, 133);
+        multiply_naive(a, b, expected);
+        multiply(a, b, blocked);
+        multiply(a, b, threaded, 3);
+        for (int i = 0; i < 70; i++) {
+            for (int j = 0; j < 133; j++) {
+                EXPECT_NEAR(blocked(i, j).real(), expected(i, j).real(), 1e-9);
+                EXPECT_NEAR(blocked(i, j).imaginary(), expected(i, j).imaginary(), 1e-9);
+            }
+        }
+        EXPECT_TRUE(blocked == threaded);
+    }
+
+    TEST(ComplexMatrix, MatrixVector) {
+        ComplexMatrix a = test_matrix(37, 21, 2.0),
+                      x = test_matrix(21, 1, 0.75);
+        ComplexVector v;
+        for (int j = 0; j < 21; j++) {
+            v.push_back(x(j, 0));
+        }
+        ComplexMatrix expected = a * x;
+        ComplexVector y = a * v, y_threaded;
+        multiply(a, v, y_threaded, 4);
+        ASSERT_EQ(y.size(), 37);
+        for (int i = 0; i < 37; i++) {
+            EXPECT_NEAR(y[i].real(), expected(i, 0).real(), 1e-9);
+            EXPECT_NEAR(y[i].imaginary(), expected(i, 0).imaginary(), 1e-9);
+            EXPECT_TRUE(y[i] == y_threaded[i]);
+        }
+    }
+
+    TEST(ComplexMatrix, DimensionMismatchThrows) {
+        ComplexMatrix a(2, 3), b(2, 3), c(2, 3);
+        EXPECT_THROW(multiply(a, b, c), std::invalid_argument);
+        ComplexVector v(2), y;
+        EXPECT_THROW(multiply(a, v, y), std::invalid_argument);
+    }
+
+}
@@ -0,0 +1,341 @@
+#ifndef BATCH_INTEGRATION_H
+#define BATCH_INTEGRATION_H
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+#include "integrator.h"
+#include "prefix_sum.h"
+
+// Offline integration of recorded samples. values[i] was sampled at times[i]
+// (in seconds), or at i * dt for the fixed step overloads. The results match
+// feeding the samples to an Integrator with the same rule one at a time:
+// cumulative[i] is its value() after the i-th update, so cumulative[0] is 0.
+// Repeated times, like repeated timestamps there, give zero-width intervals
+// that add nothing; with Simpson's rule they are skipped when forming pairs.
+//
+// The cumulative versions compute the areas of a block of intervals in one
+// vectorizable pass and then take their prefix sum while the block is still
+// in cache. With several threads the samples are split into ranges that are
+// scanned independently, and a second pass adds the total of all earlier
+// ranges to each range.
+
+namespace batch_integration_detail {
+
+    // Interval widths for sampled timestamps
+    struct SampledTimes {
+        const double* times;
+        double operator()(std::size_t j) const { return times[j] - times[j - 1]; }
+    };
+
+    // Interval widths for a fixed step
+    struct FixedStep {
+        double dt;
+        double operator()(std::size_t) const { return dt; }
+    };
+
+    // Where Simpson's rule stands between intervals: whether a pair is
+    // open, and if so the interval that opened it
+    struct SimpsonState {
+        bool open;
+        std::size_t opener;
+    };
+
+    // Writes into area[j - first], for j in [first, last) with j >= 1, the
+    // amount the integral grows by at sample j. For Simpson's rule the first
+    // interval of each pair contributes its trapezoid and the second the
+    // remainder of the pair's Simpson estimate, so partial sums still match
+    // Integrator. Zero-width intervals contribute nothing and are not paired;
+    // pair carries the pairing from one call to the next.
+    template <typename Width>
+    void interval_areas(const double* v, Width width, std::size_t first, std::size_t last,
+                        IntegrationRule rule, double* area, SimpsonState& pair) {
+        switch (rule) {
+            case IntegrationRule::Rectangle:
+                for (std::size_t j = first; j < last; j++) {
+                    area[j - first] = width(j) * v[j];
+                }
+                break;
+            case IntegrationRule::Trapezoidal:
+                for (std::size_t j = first; j < last; j++) {
+                    area[j - first] = width(j) * (v[j - 1] + v[j]) * 0.5;
+                }
+                break;
+            case IntegrationRule::Simpson: {
+                auto trapezoid = [&](std::size_t j) {
+                    area[j - first] = width(j) * (v[j - 1] + v[j]) * 0.5;
+                };
+                // Close the pair opened by interval i with interval j
+                auto close_pair = [&](std::size_t i, std::size_t j) {
+                    double h0 = width(i), h1 = width(j);
+                    double simpson = (h0 + h1) / 6 * ((2 - h1 / h0) * v[i - 1]
+                                                      + (h0 + h1) * (h0 + h1) / (h0 * h1) * v[j - 1]
+                                                      + (2 - h0 / h1) * v[j]);
+                    area[j - first] = simpson - h0 * (v[i - 1] + v[i]) * 0.5;
+                };
+                std::size_t zero = 0;
+                for (std::size_t j = first; j < last; j++) {
+                    zero += width(j) == 0;
+                }
+                if (zero) {
+                    for (std::size_t j = first; j < last; j++) {
+                        if (width(j) == 0) {
+                            area[j - first] = 0.0;
+                        } else if (pair.open) {
+                            close_pair(pair.opener, j);
+                            pair.open = false;
+                        } else {
+                            trapezoid(j);
+                            pair = SimpsonState{true, j};
+                        }
+                    }
+                    break;
+                }
+                // No zero widths: intervals pair off in order
+                std::size_t j = first;
+                if (j < last && pair.open) {
+                    close_pair(pair.opener, j++);
+                }
+                for (; j + 1 < last; j += 2) {
+                    trapezoid(j);
+                    close_pair(j, j + 1);
+                }
+                pair.open = j < last;
+                if (pair.open) {
+                    trapezoid(j);
+                    pair.opener = j;
+                }
+                break;
+            }
+        }
+    }
+
+    // The Simpson pairing at the start of each of the ranges of intervals
+    // [1 + t * chunk, 1 + (t + 1) * chunk), found by counting the nonzero
+    // widths of every range in parallel
+    template <typename Width>
+    std::vector<SimpsonState> simpson_starts(Width width, std::size_t n, std::size_t chunk, unsigned threads) {
+        std::vector<std::size_t> nonzero(threads, 0), last_nonzero(threads, 0);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < threads; t++) {
+            std::size_t first = 1 + t * chunk,
+                        last = std::min(n, first + chunk);
+            workers.push_back(std::thread([=, &nonzero, &last_nonzero]() {
+                std::size_t count = 0;
+                for (std::size_t j = first; j < last; j++) {
+                    count += width(j) != 0;
+                }
+                std::size_t j = last;
+                while (count && width(j - 1) == 0) {
+                    j--;
+                }
+                nonzero[t] = count;
+                last_nonzero[t] = j - 1;
+            }));
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        std::vector<SimpsonState> starts(threads);
+        SimpsonState pair{false, 0};
+        for (unsigned t = 0; t < threads; t++) {
+            starts[t] = pair;
+            if (nonzero[t]) {
+                pair.open = pair.open != (nonzero[t] % 2 == 1);
+                pair.opener = last_nonzero[t];
+            }
+        }
+        return starts;
+    }
+
+    // Throws if any width of intervals [first, last) is negative, and
+    // returns how many are zero. Widths are counted rather than branched on,
+    // so the loop vectorizes; the counts are only looked at afterwards.
+    template <typename Width>
+    std::size_t check_widths(Width width, std::size_t first, std::size_t last) {
+        std::size_t negative = 0, zero = 0;
+        for (std::size_t j = first; j < last; j++) {
+            double h = width(j);
+            negative += h < 0;
+            zero += h == 0;
+        }
+        if (negative) {
+            throw std::invalid_argument("Integration times must not decrease");
+        }
+        return zero;
+    }
+
+    // Samples per block: the areas of a block are computed, checked and
+    // summed while they are still in L1
+    const std::size_t BLOCK = 1024;
+
+    // Running integral over intervals [first, last) into out[first..last),
+    // starting from zero with the given Simpson pairing. Returns the total
+    // and counts the zero-width intervals into zeros.
+    template <typename Width>
+    double scan(const double* v, Width width, std::size_t first, std::size_t last,
+                IntegrationRule rule, double* out, SimpsonState pair, std::size_t& zeros) {
+        double carry = 0.0;
+        for (std::size_t start = first; start < last; start += BLOCK) {
+            std::size_t end = std::min(last, start + BLOCK);
+            zeros += check_widths(width, start, end);
+            interval_areas(v, width, start, end, rule, out + start, pair);
+            carry = prefix_sum(out + start, end - start, carry);
+        }
+        return carry;
+    }
+
+    template <typename Width>
+    void cumulative(const double* v, Width width, std::size_t n, double* out,
+                    IntegrationRule rule, unsigned threads) {
+        if (n == 0) {
+            return;
+        }
+        out[0] = 0.0;
+        std::size_t intervals = n - 1;
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        // Blocks of fewer than 64k samples are not worth a thread
+        threads = (unsigned) std::max<std::size_t>(1, std::min<std::size_t>(threads, intervals / 65536));
+
+        if (threads == 1) {
+            std::size_t zeros = 0;
+            scan(v, width, 1, n, rule, out, SimpsonState{false, 0}, zeros);
+            return;
+        }
+
+        // Each range starts from the Simpson pairing it would have if no
+        // earlier interval had zero width. Only if one did are the real
+        // starting pairings counted and the ranges scanned again.
+        std::size_t chunk = (intervals + threads - 1) / threads;
+        std::vector<SimpsonState> starts(threads);
+        for (unsigned t = 0; t < threads; t++) {
+            std::size_t first = 1 + t * chunk;
+            starts[t] = SimpsonState{first % 2 == 0, first - 1};
+        }
+        std::vector<double> totals(threads, 0.0);
+        std::vector<std::size_t> zeros(threads, 0);
+        std::vector<std::exception_ptr> errors(threads);
+        std::vector<std::thread> workers;
+
+        // Each thread scans its own range from zero
+        auto scan_ranges = [&]() {
+            for (unsigned t = 0; t < threads; t++) {
+                std::size_t first = 1 + t * chunk,
+                            last = std::min(n, first + chunk);
+                workers.push_back(std::thread([=, &starts, &totals, &zeros, &errors]() {
+                    try {
+                        zeros[t] = 0;
+                        totals[t] = scan(v, width, first, last, rule, out, starts[t], zeros[t]);
+                    } catch (...) {
+                        errors[t] = std::current_exception();
+                    }
+                }));
+            }
+            for (auto& worker : workers) {
+                worker.join();
+            }
+            workers.clear();
+            for (auto& error : errors) {
+                if (error) {
+                    std::rethrow_exception(error);
+                }
+            }
+        };
+        scan_ranges();
+        if (rule == IntegrationRule::Simpson &&
+            std::any_of(zeros.begin(), zeros.end() - 1, [](std::size_t z) { return z > 0; })) {
+            starts = simpson_starts(width, n, chunk, threads);
+            scan_ranges();
+        }
+
+        // Carry the totals of earlier ranges into each later range
+        double carry = 0.0;
+        for (unsigned t = 0; t < threads; t++) {
+            std::size_t first = 1 + t * chunk,
+                        last = std::min(n, first + chunk);
+            if (t > 0 && first < last) {
+                workers.push_back(std::thread([=]() {
+                    for (std::size_t j = first; j < last; j++) {
+                        out[j] += carry;
+                    }
+                }));
+            }
+            carry += totals[t];
+        }
+        for (auto& worker : workers) {
+            worker.join();
+        }
+    }
+
+    template <typename Width>
+    double total(const double* v, Width width, std::size_t n, IntegrationRule rule) {
+        if (n < 2) {
+            return 0.0;
+        }
+        // Four independent partial sums of each block of areas
+        double area[BLOCK];
+        double s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        SimpsonState pair{false, 0};
+        for (std::size_t first = 1; first < n; first += BLOCK) {
+            std::size_t last = std::min(n, first + BLOCK),
+                        m = last - first;
+            check_widths(width, first, last);
+            interval_areas(v, width, first, last, rule, area, pair);
+            std::size_t i = 0;
+            for (; i + 4 <= m; i += 4) {
+                s0 += area[i];
+                s1 += area[i + 1];
+                s2 += area[i + 2];
+                s3 += area[i + 3];
+            }
+            for (; i < m; i++) {
+                s0 += area[i];
+            }
+        }
+        return (s0 + s1) + (s2 + s3);
+    }
+
+}
+
+// Final value of the integral of n samples taken at the given times
+inline double integrate(const double* values, const double* times, std::size_t n,
+                        IntegrationRule rule = IntegrationRule::Rectangle) {
+    return batch_integration_detail::total(values, batch_integration_detail::SampledTimes{times}, n, rule);
+}
+
+// Final value of the integral of n samples taken dt seconds apart
+inline double integrate(const double* values, double dt, std::size_t n,
+                        IntegrationRule rule = IntegrationRule::Rectangle) {
+    return batch_integration_detail::total(values, batch_integration_detail::FixedStep{dt}, n, rule);
+}
+
+// Integral up to every sample, written to out[0..n). Zero threads means one
+// per hardware thread. If the times are invalid the contents of out are
+// unspecified.
+inline void cumulative_integrate(const double* values, const double* times, std::size_t n, double* out,
+                                 IntegrationRule rule = IntegrationRule::Rectangle, unsigned threads = 1) {
+    batch_integration_detail::cumulative(values, batch_integration_detail::SampledTimes{times}, n, out, rule, threads);
+}
+
+inline void cumulative_integrate(const double* values, double dt, std::size_t n, double* out,
+                                 IntegrationRule rule = IntegrationRule::Rectangle, unsigned threads = 1) {
+    batch_integration_detail::cumulative(values, batch_integration_detail::FixedStep{dt}, n, out, rule, threads);
+}
+
+inline std::vector<double> cumulative_integrate(const std::vector<double>& values, const std::vector<double>& times,
+                                                IntegrationRule rule = IntegrationRule::Rectangle,
+                                                unsigned threads = 1) {
+    if (values.size() != times.size()) {
+        throw std::invalid_argument("Values and times must have the same length");
+    }
+    std::vector<double> out(values.size());
+    cumulative_integrate(values.data(), times.data(), values.size(), out.data(), rule, threads);
+    return out;
+}
+
+#endif // BATCH_INTEGRATION_H
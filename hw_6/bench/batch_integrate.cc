@@ -0,0 +1,65 @@
+// Throughput of integrating recorded samples: streaming updates through an
+// Integrator with explicit timestamps against the batch functions, for each
+// rule and for 1, 2 and 4 threads.
+
+#include <stdio.h>
+#include <chrono>
+#include <vector>
+#include "integrator.h"
+#include "batch_integration.h"
+#include "stopwatch.h"
+
+typedef BasicIntegrator<std::chrono::steady_clock> SteadyIntegrator;
+
+static const char* rule_name(IntegrationRule rule) {
+    switch (rule) {
+        case IntegrationRule::Rectangle: return "rectangle";
+        case IntegrationRule::Trapezoidal: return "trapezoidal";
+        case IntegrationRule::Simpson: return "simpson";
+    }
+    return "";
+}
+
+int main() {
+    const size_t n = 1 << 24;
+    std::vector<double> values(n), times(n), out(n);
+    std::vector<SteadyIntegrator::time_point> stamps(n);
+    for (size_t i = 0; i < n; i++) {
+        values[i] = (double) ((i * 2654435761u) % 100003) / 100003.0;
+        times[i] = 1e-3 * i + 1e-4 * (i % 3);
+        stamps[i] = SteadyIntegrator::time_point(std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+            std::chrono::duration<double>(times[i])));
+    }
+
+    for (IntegrationRule rule : {IntegrationRule::Rectangle, IntegrationRule::Trapezoidal,
+                                 IntegrationRule::Simpson}) {
+        Stopwatch watch;
+        SteadyIntegrator integrator("stream", rule);
+        watch.start();
+        for (size_t i = 0; i < n; i++) {
+            integrator.update(values[i], stamps[i]);
+        }
+        watch.stop();
+        printf("%-12s %-18s %8.3f ns/sample   (value %.6g)\n", rule_name(rule), "streaming",
+               watch.get_nanoseconds() / n, integrator.value());
+
+        watch.reset();
+        watch.start();
+        double total = integrate(values.data(), times.data(), n, rule);
+        watch.stop();
+        printf("%-12s %-18s %8.3f ns/sample   (value %.6g)\n", rule_name(rule), "integrate",
+               watch.get_nanoseconds() / n, total);
+
+        for (unsigned threads : {1u, 2u, 4u}) {
+            char label[32];
+            snprintf(label, sizeof label, "cumulative x%u", threads);
+            watch.reset();
+            watch.start();
+            cumulative_integrate(values.data(), times.data(), n, out.data(), rule, threads);
+            watch.stop();
+            printf("%-12s %-18s %8.3f ns/sample   (value %.6g)\n", rule_name(rule), label,
+                   watch.get_nanoseconds() / n, out[n - 1]);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,102 @@
+// Throughput and latency of the channels between two pinned threads.
+// Throughput is one value per push and pop, then batches of 64. Latency is
+// half the round trip of a value bounced back over a second channel. With a
+// single CPU both threads share it and the numbers mostly measure yields.
+
+#include <stdio.h>
+#include <algorithm>
+#include <thread>
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+#include "channel.h"
+#include "stopwatch.h"
+
+// Pin the calling thread to a CPU, wrapping around if there are fewer.
+// Affinity is Linux-only; elsewhere threads are left where the OS puts them.
+static void pin(unsigned cpu) {
+#if defined(__linux__)
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu % std::max(1u, std::thread::hardware_concurrency()), &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void) cpu;
+#endif
+}
+
+template <typename Channel>
+void throughput(const char* name, size_t batch, long n) {
+    Channel channel(4096);
+    Stopwatch watch;
+    watch.start();
+    std::thread producer([&]() {
+        pin(1);
+        double values[64] = {0};
+        for (long sent = 0; sent < n;) {
+            size_t count = batch == 1 ? channel.try_push((double) sent)
+                                      : channel.push_n(values, std::min<long>(batch, n - sent));
+            sent += count;
+            if (count == 0) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    pin(0);
+    double values[64];
+    for (long received = 0; received < n;) {
+        size_t count = batch == 1 ? channel.try_pop(values[0]) : channel.pop_n(values, batch);
+        received += count;
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    watch.stop();
+    printf("%-5s batch %3zu %10.2f ns/value %8.1f M values/s\n", name, batch,
+           watch.get_nanoseconds() / n, n / watch.get_nanoseconds() * 1e3);
+}
+
+template <typename Channel>
+void latency(const char* name, long round_trips) {
+    Channel there(64), back(64);
+    std::thread echo([&]() {
+        pin(1);
+        double x;
+        for (long i = 0; i < round_trips; i++) {
+            while (!there.try_pop(x)) {
+                std::this_thread::yield();
+            }
+            while (!back.try_push(x)) {
+                std::this_thread::yield();
+            }
+        }
+    });
+    pin(0);
+    Stopwatch watch;
+    watch.start();
+    double x;
+    for (long i = 0; i < round_trips; i++) {
+        while (!there.try_push((double) i)) {
+            std::this_thread::yield();
+        }
+        while (!back.try_pop(x)) {
+            std::this_thread::yield();
+        }
+    }
+    watch.stop();
+    echo.join();
+    printf("%-5s one way    %10.0f ns\n", name, watch.get_nanoseconds() / round_trips / 2);
+}
+
+int main() {
+    const long n = 1 << 24;
+    throughput<SpscChannel<double>>("spsc", 1, n);
+    throughput<SpscChannel<double>>("spsc", 64, n);
+    throughput<MpscChannel<double>>("mpsc", 1, n);
+    throughput<MpscChannel<double>>("mpsc", 64, n);
+    latency<SpscChannel<double>>("spsc", 100000);
+    latency<MpscChannel<double>>("mpsc", 100000);
+    return 0;
+}
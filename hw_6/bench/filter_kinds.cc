@@ -0,0 +1,48 @@
+// Per-update cost of each streaming filter at window sizes 10, 1k and 100k.
+// The exponential moving average has no window and is listed once.
+
+#include <stdio.h>
+#include <vector>
+#include "filter.h"
+#include "ema_filter.h"
+#include "median_filter.h"
+#include "extremum_filter.h"
+#include "stopwatch.h"
+
+template <typename F>
+void run(const char* name, size_t window, F& filter, const std::vector<double>& input) {
+    // Fill the window first so only steady state updates are timed
+    for (size_t i = 0; i < window && i < input.size(); i++) {
+        filter.update(input[i]);
+    }
+    Stopwatch watch;
+    watch.start();
+    for (double x : input) {
+        filter.update(x);
+    }
+    watch.stop();
+    printf("%-14s %8zu %10.2f ns/update   (value %g)\n", name, window,
+           watch.get_nanoseconds() / input.size(), filter.value());
+}
+
+int main() {
+    std::vector<double> input(1 << 21);
+    for (size_t i = 0; i < input.size(); i++) {
+        input[i] = (double) ((i * 2654435761u) % 100003) / 100003.0;
+    }
+
+    printf("%-14s %8s\n", "filter", "window");
+    EmaFilter ema("ema", 0.1);
+    run("ema", 0, ema, input);
+    for (size_t window : {10, 1000, 100000}) {
+        DynamicFilter average("average", window);
+        MedianFilter median("median", window);
+        MinFilter min_filter("min", window);
+        MaxFilter max_filter("max", window);
+        run("average", window, average, input);
+        run("median", window, median, input);
+        run("min", window, min_filter, input);
+        run("max", window, max_filter, input);
+    }
+    return 0;
+}
@@ -0,0 +1,94 @@
+// Measures the cost of one Filter::update() call, compared with the
+// previous implementation that kept a std::deque and re-summed it on
+// every sample, and the per-sample cost of the block update. Run with
+// --help for the harness options (filtering, CSV/JSON, baselines).
+
+#include <deque>
+#include <vector>
+#include "benchmark.h"
+#include "filter.h"
+
+// The deque-based filter this header used to contain, kept for comparison
+class DequeFilter {
+    std::deque<double> values;
+    double running_avg = 0.0;
+
+public:
+    explicit DequeFilter(const char*) {}
+
+    void update(double input_value) {
+        values.push_back(input_value);
+        if (values.size() > 10) {
+            values.pop_front();
+        }
+        double sum = 0.0;
+        for (double val : values) {
+            sum += val;
+        }
+        running_avg = sum / values.size();
+    }
+
+    double value() const { return running_avg; }
+};
+
+// A DynamicFilter with its window fixed, so all filters construct alike
+template <std::size_t W>
+class WindowedFilter : public DynamicFilter {
+public:
+    explicit WindowedFilter(const char* name) : DynamicFilter(name, W) {}
+};
+
+typedef TypedFilter<float, 10> FloatFilter;
+
+const std::size_t INPUT_SIZE = 1 << 16;
+
+template <typename T>
+const std::vector<T>& input() {
+    static std::vector<T> values = []() {
+        std::vector<T> v(INPUT_SIZE);
+        for (std::size_t i = 0; i < v.size(); i++) {
+            v[i] = (T) ((i * 2654435761u) % 1000) / (T) 1000;
+        }
+        return v;
+    }();
+    return values;
+}
+
+// One update() per iteration
+template <typename F, typename T>
+void update(BenchmarkState& state) {
+    F filter("bench");
+    const std::vector<T>& x = input<T>();
+    std::size_t i = 0;
+    for (auto _ : state) {
+        filter.update(x[i]);
+        i = (i + 1) & (INPUT_SIZE - 1);
+    }
+    double result = filter.value();
+    do_not_optimize(result);
+}
+
+// One block update of the whole input per iteration
+template <typename F, bool WITH_OUTPUT>
+void update_block(BenchmarkState& state) {
+    F filter("bench");
+    const std::vector<double>& x = input<double>();
+    std::vector<double> output(x.size());
+    state.set_items_per_iteration((double) x.size());
+    for (auto _ : state) {
+        filter.update(x.data(), x.size(), WITH_OUTPUT ? output.data() : nullptr);
+        clobber_memory();
+    }
+    double result = filter.value();
+    do_not_optimize(result);
+}
+
+BENCHMARK_NAMED("update/deque", (update<DequeFilter, double>));
+BENCHMARK_NAMED("update/Filter", (update<Filter, double>));
+BENCHMARK_NAMED("update/DynamicFilter", (update<WindowedFilter<10>, double>));
+BENCHMARK_NAMED("update/TypedFilter<float>", (update<FloatFilter, float>));
+BENCHMARK_NAMED("block/Filter", (update_block<Filter, true>));
+BENCHMARK_NAMED("block/DynamicFilter w=1000", (update_block<WindowedFilter<1000>, true>));
+BENCHMARK_NAMED("block/Filter no output", (update_block<Filter, false>));
+
+BENCHMARK_MAIN();
@@ -0,0 +1,66 @@
+// Cost per random value of each engine, one update() at a time and in bulk
+// with generate(), and the cost of constructing a process from the operating
+// system's entropy or from a master seed and stream id. The processes keep
+// no history so only generation is timed.
+
+#include <stdio.h>
+#include <vector>
+#include "random_process.h"
+#include "stopwatch.h"
+
+template <typename Process>
+void run(const char* name, size_t n) {
+    Process process(name, HistoryPolicy::None);
+    Stopwatch watch;
+    watch.start();
+    double sum = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        process.update();
+        sum += process.latest();
+    }
+    watch.stop();
+    printf("%-10s %-8s %8.3f ns/sample   (mean %.4f)\n", name, "update",
+           watch.get_nanoseconds() / n, sum / n);
+
+    std::vector<double> out(1 << 16);
+    size_t calls = n / out.size();
+    watch.reset();
+    watch.start();
+    for (size_t i = 0; i < calls; i++) {
+        process.generate(out.size(), out.data());
+    }
+    watch.stop();
+    printf("%-10s %-8s %8.3f ns/sample   (last %.4f)\n", name, "generate",
+           watch.get_nanoseconds() / (calls * out.size()), process.latest());
+
+    const size_t constructions = 10000;
+    double check = 0.0;
+    watch.reset();
+    watch.start();
+    for (size_t i = 0; i < constructions; i++) {
+        Process seeded(name, HistoryPolicy::None);
+        seeded.update();
+        check += seeded.latest();
+    }
+    watch.stop();
+    printf("%-10s %-8s %8.0f ns/process\n", name, "entropy", watch.get_nanoseconds() / constructions);
+    watch.reset();
+    watch.start();
+    for (size_t i = 0; i < constructions; i++) {
+        Process seeded(name, 42, i, HistoryPolicy::None);
+        seeded.update();
+        check += seeded.latest();
+    }
+    watch.stop();
+    printf("%-10s %-8s %8.0f ns/process   (mean %.3f)\n", name, "stream",
+           watch.get_nanoseconds() / constructions, check / (2 * constructions));
+}
+
+int main() {
+    const size_t n = 1 << 26;
+    run<RandomProcess>("mt19937", n);
+    run<XoshiroRandomProcess>("xoshiro", n);
+    run<PcgRandomProcess>("pcg64", n);
+    run<PhiloxRandomProcess>("philox", n);
+    return 0;
+}
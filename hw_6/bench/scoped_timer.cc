@@ -0,0 +1,57 @@
+// Overhead of SCOPED_TIMER around a trivial region, on one thread and on
+// four at once, against the same loop without the timer. Times are wall
+// time over all iterations of all threads. Ends with the registry's text
+// report of the timed regions.
+
+#include <stdio.h>
+#include <iostream>
+#include <thread>
+#include <vector>
+#include "scoped_timer.h"
+#include "stopwatch.h"
+
+static volatile double sink;
+
+void plain(long n) {
+    double x = 0.0;
+    for (long i = 0; i < n; i++) {
+        x += i;
+        sink = x;
+    }
+}
+
+void timed(long n) {
+    double x = 0.0;
+    for (long i = 0; i < n; i++) {
+        SCOPED_TIMER("bench.region");
+        x += i;
+        sink = x;
+    }
+}
+
+template <typename F>
+double ns_per_iteration(F f, long n, unsigned threads) {
+    Stopwatch watch;
+    watch.start();
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.push_back(std::thread(f, n));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    watch.stop();
+    return watch.get_nanoseconds() / (n * threads);
+}
+
+int main() {
+    const long n = 10000000;
+    for (unsigned threads : {1u, 4u}) {
+        double base = ns_per_iteration(plain, n, threads),
+               with_timer = ns_per_iteration(timed, n, threads);
+        printf("%u threads: %6.2f ns plain, %6.2f ns timed, %6.2f ns per timer\n",
+               threads, base, with_timer, with_timer - base);
+    }
+    TimerRegistry::instance().print(std::cout);
+    return 0;
+}
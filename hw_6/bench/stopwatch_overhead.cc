@@ -0,0 +1,64 @@
+// Cost of a clock read and of a start/stop pair for each stopwatch clock
+// policy, with the old high_resolution_clock read as a baseline, and the
+// extra cost of recording laps in a histogram. The loop bodies are empty,
+// so the times are pure timing overhead.
+
+#include <stdio.h>
+#include <chrono>
+#include "stopwatch.h"
+
+template <typename Clock>
+void clock_read(const char* name, long n) {
+    Stopwatch watch;
+    typename Clock::ticks sum = 0;
+    watch.start();
+    for (long i = 0; i < n; i++) {
+        sum += Clock::now();
+    }
+    watch.stop();
+    printf("%-22s %8.2f ns   (%lld)\n", name, watch.get_nanoseconds() / n, (long long) (sum & 1));
+}
+
+template <typename Watch>
+void start_stop(const char* name, long n, LatencyHistogram* laps = nullptr) {
+    Stopwatch outer;
+    Watch watch;
+    watch.record_laps(laps);
+    outer.start();
+    for (long i = 0; i < n; i++) {
+        watch.start();
+        watch.stop();
+    }
+    outer.stop();
+    printf("%-22s %8.2f ns   (%lld ticks measured)\n", name, outer.get_nanoseconds() / n,
+           (long long) watch.get_ticks());
+}
+
+int main() {
+    const long n = 10000000;
+    TscClock::calibrate();
+
+    Stopwatch watch;
+    long long sum = 0;
+    watch.start();
+    for (long i = 0; i < n; i++) {
+        sum += std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    }
+    watch.stop();
+    printf("%-22s %8.2f ns   (%lld)\n", "high_resolution_clock", watch.get_nanoseconds() / n, sum & 1);
+
+    clock_read<SteadyClock>("SteadyClock::now", n);
+    clock_read<TscClock>("TscClock::now", n);
+    start_stop<Stopwatch>("Stopwatch start/stop", n);
+    start_stop<TscStopwatch>("TscStopwatch start/stop", n);
+
+    LatencyHistogram laps;
+    start_stop<Stopwatch>("Stopwatch laps", n, &laps);
+    printf("    p50 %llu  p99 %llu  p99.9 %llu  max %llu ns\n", (unsigned long long) laps.p50(),
+           (unsigned long long) laps.p99(), (unsigned long long) laps.p999(), (unsigned long long) laps.max());
+    laps.reset();
+    start_stop<TscStopwatch>("TscStopwatch laps", n, &laps);
+    printf("    p50 %llu  p99 %llu  p99.9 %llu  max %llu ns\n", (unsigned long long) laps.p50(),
+           (unsigned long long) laps.p99(), (unsigned long long) laps.p999(), (unsigned long long) laps.max());
+    return 0;
+}
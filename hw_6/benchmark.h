@@ -0,0 +1,426 @@
+#ifndef BENCHMARK_H
+#define BENCHMARK_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <map>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "stopwatch.h"
+
+// A small microbenchmark harness. A benchmark is a function that times a
+// loop over its state:
+//
+//     BENCHMARK(filter_update) {
+//         Filter filter("f");
+//         for (auto _ : state) {
+//             filter.update(1.0);
+//             do_not_optimize(filter.value());
+//         }
+//     }
+//
+//     BENCHMARK_MAIN();
+//
+// Only the loop is timed. The harness picks the iteration count so that one
+// run takes at least --min-time seconds, runs once more to warm up, then
+// repeats the run --repetitions times and reports the mean, standard
+// deviation and minimum time per iteration. Results print as a table, CSV
+// or JSON; a CSV saved from an earlier run can be passed back with
+// --baseline=file to print the change against it.
+
+// Keep the compiler from discarding a value that is computed but not used
+template <typename T>
+inline void do_not_optimize(const T& value) {
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+// A non-const object is passed by address, so the compiler must also assume
+// it was modified and cannot carry its contents over from before
+template <typename T>
+inline void do_not_optimize(T& value) {
+    asm volatile("" : : "g"(&value) : "memory");
+}
+
+// Make the compiler assume all memory was read and written here, so stores
+// before it are not dropped or sunk out of the loop
+inline void clobber_memory() {
+    asm volatile("" : : : "memory");
+}
+
+// What a benchmark function loops over: for (auto _ : state) { ... }
+class BenchmarkState {
+public:
+    explicit BenchmarkState(long iterations) : n(iterations), items(1.0) {}
+
+    BenchmarkState(const BenchmarkState&) = delete;
+    BenchmarkState& operator=(const BenchmarkState&) = delete;
+
+    class Iterator {
+    public:
+        Iterator(BenchmarkState* state, long remaining) : state(state), remaining(remaining) {}
+
+        // Nothing to read; "for (auto _ : state)" only counts iterations
+        struct Value {
+            ~Value() {}   // Not trivial, so an unused loop variable draws no warning
+        };
+        Value operator*() const { return Value(); }
+        Iterator& operator++() {
+            remaining--;
+            return *this;
+        }
+
+        // The loop ending stops the clock
+        bool operator!=(const Iterator&) {
+            if (remaining > 0) {
+                return true;
+            }
+            state->watch.stop();
+            return false;
+        }
+
+    private:
+        BenchmarkState* state;
+        long remaining;
+    };
+
+    // Starting the loop starts the clock
+    Iterator begin() {
+        if (looped) {
+            throw std::logic_error("A benchmark can only loop over its state once");
+        }
+        looped = true;
+        watch.start();
+        return Iterator(this, n);
+    }
+
+    Iterator end() {
+        return Iterator(this, 0);
+    }
+
+    // Leave per-iteration setup out of the time
+    void pause_timing() { watch.stop(); }
+    void resume_timing() { watch.start(); }
+
+    // Work items per iteration, for a time per item as well
+    void set_items_per_iteration(double count) { items = count; }
+
+    long iterations() const { return n; }
+    double items_per_iteration() const { return items; }
+    bool has_looped() const { return looped; }
+    double get_nanoseconds() const { return watch.get_nanoseconds(); }
+
+private:
+    long n;
+    double items;
+    bool looped = false;
+    Stopwatch watch;
+};
+
+typedef std::function<void(BenchmarkState&)> BenchmarkFunction;
+
+// Times per iteration are in nanoseconds
+struct BenchmarkResult {
+    std::string name;
+    long iterations;     // Per repetition
+    int repetitions;
+    double mean, stddev, min;
+    double items;        // Per iteration
+};
+
+struct BenchmarkOptions {
+    std::string filter;        // Run only names containing this
+    double min_time = 0.1;     // Seconds per repetition, at least
+    int repetitions = 5;
+    std::string format = "text";
+    std::string baseline;      // CSV file of an earlier run
+};
+
+class BenchmarkRegistry {
+public:
+    static BenchmarkRegistry& instance() {
+        static BenchmarkRegistry registry;
+        return registry;
+    }
+
+    // Register a benchmark; the result only exists to run this at static
+    // initialization
+    int add(const std::string& name, BenchmarkFunction function) {
+        benchmarks.push_back({name, function});
+        return (int) benchmarks.size();
+    }
+
+    const std::vector<std::pair<std::string, BenchmarkFunction>>& all() const {
+        return benchmarks;
+    }
+
+private:
+    BenchmarkRegistry() {}
+    std::vector<std::pair<std::string, BenchmarkFunction>> benchmarks;
+};
+
+namespace benchmark_detail {
+
+    // Nanoseconds for one run of n iterations
+    inline double run_once(const BenchmarkFunction& function, long n, double* items = nullptr) {
+        BenchmarkState state(n);
+        function(state);
+        if (!state.has_looped()) {
+            throw std::logic_error("A benchmark must loop over its state");
+        }
+        if (items) {
+            *items = state.items_per_iteration();
+        }
+        return state.get_nanoseconds();
+    }
+
+    // Iteration count that makes one run last at least min_time seconds
+    inline long calibrate(const BenchmarkFunction& function, double min_time) {
+        const double target = min_time * 1e9;
+        long n = 1;
+        for (;;) {
+            double t = run_once(function, n);
+            if (t >= target || n >= 1000000000L) {
+                return n;
+            }
+            // Aim 40% past the target, growing at least 2x and at most 100x
+            double guess = t > 0 ? n * 1.4 * target / t : n * 100.0;
+            n = (long) std::min(std::max(guess, 2.0 * n), 100.0 * n);
+        }
+    }
+
+    // Mean column of a CSV written with --format=csv, by name
+    inline std::map<std::string, double> read_baseline(const std::string& path) {
+        std::ifstream in(path);
+        if (!in) {
+            throw std::runtime_error("Cannot read baseline " + path);
+        }
+        std::map<std::string, double> means;
+        std::string line;
+        std::getline(in, line);   // header
+        while (std::getline(in, line)) {
+            if (line.size() < 2 || line[0] != '"') {
+                continue;
+            }
+            // The quoted name, with doubled quotes inside it
+            std::string name;
+            std::size_t at = 1;
+            bool closed = false;
+            while (!closed) {
+                std::size_t quote = line.find('"', at);
+                if (quote == std::string::npos) {
+                    break;
+                }
+                name.append(line, at, quote - at);
+                closed = quote + 1 == line.size() || line[quote + 1] != '"';
+                if (!closed) {
+                    name += '"';
+                }
+                at = quote + (closed ? 1 : 2);
+            }
+            if (!closed || at >= line.size() || line[at] != ',') {
+                continue;
+            }
+            std::istringstream fields(line.substr(at + 1));
+            std::string field;
+            for (int column = 0; column < 3 && std::getline(fields, field, ','); column++) {
+                if (column == 2) {
+                    means[name] = std::atof(field.c_str());
+                }
+            }
+        }
+        return means;
+    }
+
+}
+
+inline BenchmarkResult run_benchmark(const std::string& name, const BenchmarkFunction& function,
+                                     const BenchmarkOptions& options) {
+    long n = benchmark_detail::calibrate(function, options.min_time);
+    BenchmarkResult r{name, n, options.repetitions, 0.0, 0.0, 0.0, 1.0};
+    benchmark_detail::run_once(function, n);   // warm up at the final count
+
+    std::vector<double> times;
+    for (int i = 0; i < options.repetitions; i++) {
+        times.push_back(benchmark_detail::run_once(function, n, &r.items) / n);
+    }
+    double sum = 0.0;
+    for (double t : times) {
+        sum += t;
+    }
+    r.mean = sum / times.size();
+    double squares = 0.0;
+    for (double t : times) {
+        squares += (t - r.mean) * (t - r.mean);
+    }
+    r.stddev = times.size() > 1 ? std::sqrt(squares / (times.size() - 1)) : 0.0;
+    r.min = *std::min_element(times.begin(), times.end());
+    return r;
+}
+
+namespace benchmark_detail {
+
+    inline std::string text_header(bool with_baseline) {
+        char line[256];
+        snprintf(line, sizeof line, "%-40s %12s %12s %8s %12s %12s%s\n", "name", "iterations",
+                 "mean ns", "stddev", "min ns", "ns/item", with_baseline ? "     change" : "");
+        return line;
+    }
+
+    inline std::string text_row(const BenchmarkResult& r, const std::map<std::string, double>& baseline) {
+        char line[256];
+        snprintf(line, sizeof line, "%-40s %12ld %12.3f %7.1f%% %12.3f %12.4f", r.name.c_str(),
+                 r.iterations, r.mean, r.mean > 0 ? 100.0 * r.stddev / r.mean : 0.0, r.min,
+                 r.mean / r.items);
+        std::string row = line;
+        auto old = baseline.find(r.name);
+        if (old != baseline.end() && old->second > 0) {
+            snprintf(line, sizeof line, " %+9.1f%%", 100.0 * (r.mean / old->second - 1.0));
+            row += line;
+        } else if (!baseline.empty()) {
+            row += "        new";
+        }
+        return row + "\n";
+    }
+
+}
+
+// Aligned text table, with the change against a baseline when there is one
+inline void print_benchmark_text(std::ostream& out, const std::vector<BenchmarkResult>& results,
+                                 const std::map<std::string, double>& baseline = {}) {
+    out << benchmark_detail::text_header(!baseline.empty());
+    for (const BenchmarkResult& r : results) {
+        out << benchmark_detail::text_row(r, baseline);
+    }
+}
+
+// One row per benchmark; --baseline reads this back
+inline void print_benchmark_csv(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    std::ios_base::fmtflags flags = out.flags();
+    std::streamsize precision = out.precision();
+    out << "name,iterations,repetitions,mean_ns,stddev_ns,min_ns,ns_per_item\n" << std::fixed;
+    for (const BenchmarkResult& r : results) {
+        // Quoted, with any quote in the name doubled
+        out << '"';
+        for (char c : r.name) {
+            out << c;
+            if (c == '"') {
+                out << '"';
+            }
+        }
+        out << "\"," << r.iterations << ',' << r.repetitions << std::setprecision(4)
+            << ',' << r.mean << ',' << r.stddev << ',' << r.min
+            << std::setprecision(6) << ',' << r.mean / r.items << '\n';
+    }
+    out.flags(flags);
+    out.precision(precision);
+}
+
+inline void print_benchmark_json(std::ostream& out, const std::vector<BenchmarkResult>& results) {
+    out << "[";
+    bool first = true;
+    char line[256];
+    for (const BenchmarkResult& r : results) {
+        out << (first ? "\n" : ",\n") << "  {\"name\": \"";
+        for (char c : r.name) {
+            if (c == '"' || c == '\\') {
+                out << '\\';
+            }
+            out << c;
+        }
+        snprintf(line, sizeof line,
+                 "\", \"iterations\": %ld, \"repetitions\": %d, \"mean_ns\": %.4f, "
+                 "\"stddev_ns\": %.4f, \"min_ns\": %.4f, \"ns_per_item\": %.6f}",
+                 r.iterations, r.repetitions, r.mean, r.stddev, r.min, r.mean / r.items);
+        out << line;
+        first = false;
+    }
+    out << (first ? "]\n" : "\n]\n");
+}
+
+// Parse the command line, run the registered benchmarks whose names match
+// and print the results to standard output. Returns the exit status.
+inline int run_benchmarks(int argc, char** argv) {
+    BenchmarkOptions options;
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i], value;
+        std::size_t equals = arg.find('=');
+        if (equals != std::string::npos) {
+            value = arg.substr(equals + 1);
+            arg = arg.substr(0, equals);
+        }
+        if (arg == "--filter") {
+            options.filter = value;
+        } else if (arg == "--min-time" && std::atof(value.c_str()) > 0) {
+            options.min_time = std::atof(value.c_str());
+        } else if (arg == "--repetitions" && std::atoi(value.c_str()) > 0) {
+            options.repetitions = std::atoi(value.c_str());
+        } else if (arg == "--format" && (value == "text" || value == "csv" || value == "json")) {
+            options.format = value;
+        } else if (arg == "--baseline" && !value.empty()) {
+            options.baseline = value;
+        } else {
+            fprintf(stderr, "usage: %s [--filter=substring] [--min-time=seconds] [--repetitions=n]\n"
+                            "       [--format=text|csv|json] [--baseline=earlier.csv]\n", argv[0]);
+            return arg == "--help" ? 0 : 1;
+        }
+    }
+
+    try {
+        std::map<std::string, double> baseline;
+        if (!options.baseline.empty()) {
+            baseline = benchmark_detail::read_baseline(options.baseline);
+        }
+        std::vector<BenchmarkResult> results;
+        if (options.format == "text") {
+            std::cout << benchmark_detail::text_header(!baseline.empty());
+        }
+        for (const auto& benchmark : BenchmarkRegistry::instance().all()) {
+            if (benchmark.first.find(options.filter) == std::string::npos) {
+                continue;
+            }
+            results.push_back(run_benchmark(benchmark.first, benchmark.second, options));
+            if (options.format == "text") {
+                // Print as we go; a full run can take a while
+                std::cout << benchmark_detail::text_row(results.back(), baseline) << std::flush;
+            }
+        }
+        if (options.format == "csv") {
+            print_benchmark_csv(std::cout, results);
+        } else if (options.format == "json") {
+            print_benchmark_json(std::cout, results);
+        }
+    } catch (const std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    return 0;
+}
+
+#define BENCHMARK_JOIN2(a, b) a##b
+#define BENCHMARK_JOIN(a, b) BENCHMARK_JOIN2(a, b)
+
+// Define and register a benchmark function taking BenchmarkState& state
+#define BENCHMARK(name) \
+    static void name(BenchmarkState& state); \
+    static const int BENCHMARK_JOIN(benchmark_registered_, name) = \
+        BenchmarkRegistry::instance().add(#name, name); \
+    static void name(BenchmarkState& state)
+
+// Register an existing function, such as a template instance, under a
+// label. Named by __COUNTER__, so several can share a line or a macro.
+#define BENCHMARK_NAMED(label, function) \
+    static const int BENCHMARK_JOIN(benchmark_registered_, __COUNTER__) = \
+        BenchmarkRegistry::instance().add(label, function)
+
+#define BENCHMARK_MAIN() \
+    int main(int argc, char** argv) { return run_benchmarks(argc, argv); }
+
+#endif // BENCHMARK_H
@@ -0,0 +1,304 @@
+#ifndef CHANNEL_H
+#define CHANNEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <memory>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+
+// Bounded lock-free queues for handing values between threads, for example
+// from a RandomProcess on one thread to a Filter on another. Nothing blocks:
+// push fails when the channel is full and pop when it is empty, and the
+// caller decides whether to retry, yield or drop. Capacities are rounded up
+// to a power of two.
+
+namespace channel_detail {
+
+    // Destructive interference size: indices written by different threads
+    // are kept this far apart so they do not share a cache line
+    constexpr std::size_t CACHE_LINE = 64;
+
+    inline std::size_t round_capacity(std::size_t capacity) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Channel capacity must be positive");
+        }
+        std::size_t rounded = 2;
+        while (rounded < capacity) {
+            rounded *= 2;
+        }
+        return rounded;
+    }
+
+}
+
+// Single producer, single consumer. Each side owns one index and keeps a
+// cached copy of the other's, so in steady state a push or pop touches no
+// cache line written by the other thread except the slot itself.
+template <typename T>
+class SpscChannel {
+public:
+    explicit SpscChannel(std::size_t capacity) :
+        mask(channel_detail::round_capacity(capacity) - 1),
+        slots(new T[mask + 1]) {}
+
+    SpscChannel(const SpscChannel&) = delete;
+    SpscChannel& operator=(const SpscChannel&) = delete;
+
+    std::size_t capacity() const { return mask + 1; }
+
+    // Number of values waiting. Exact only when neither side is active.
+    // Head is read first: it never passes tail, so the difference cannot
+    // wrap, and it is capped in case the producer ran ahead in between.
+    std::size_t size() const {
+        std::size_t head = consumer.head.load(std::memory_order_acquire);
+        std::size_t tail = producer.tail.load(std::memory_order_acquire);
+        return std::min(tail - head, capacity());
+    }
+
+    // Producer side: add one value, or return false if the channel is full
+    bool try_push(const T& value) {
+        std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+        if (tail - producer.cached_head == capacity()) {
+            producer.cached_head = consumer.head.load(std::memory_order_acquire);
+            if (tail - producer.cached_head == capacity()) {
+                return false;
+            }
+        }
+        slots[tail & mask] = value;
+        producer.tail.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side: add up to n values and return how many fit. They
+    // become visible to the consumer together.
+    std::size_t push_n(const T* values, std::size_t n) {
+        std::size_t tail = producer.tail.load(std::memory_order_relaxed);
+        std::size_t space = capacity() - (tail - producer.cached_head);
+        if (space < n) {
+            producer.cached_head = consumer.head.load(std::memory_order_acquire);
+            space = capacity() - (tail - producer.cached_head);
+        }
+        std::size_t count = std::min(n, space),
+                    start = tail & mask,
+                    first = std::min(count, capacity() - start);
+        std::copy(values, values + first, slots.get() + start);
+        std::copy(values + first, values + count, slots.get());
+        producer.tail.store(tail + count, std::memory_order_release);
+        return count;
+    }
+
+    // Consumer side: take one value, or return false if the channel is empty
+    bool try_pop(T& value) {
+        std::size_t head = consumer.head.load(std::memory_order_relaxed);
+        if (head == consumer.cached_tail) {
+            consumer.cached_tail = producer.tail.load(std::memory_order_acquire);
+            if (head == consumer.cached_tail) {
+                return false;
+            }
+        }
+        value = std::move(slots[head & mask]);
+        consumer.head.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: take up to n values, oldest first, and return how many
+    std::size_t pop_n(T* values, std::size_t n) {
+        std::size_t head = consumer.head.load(std::memory_order_relaxed);
+        if (consumer.cached_tail - head < n) {
+            consumer.cached_tail = producer.tail.load(std::memory_order_acquire);
+        }
+        std::size_t count = std::min(n, consumer.cached_tail - head),
+                    start = head & mask,
+                    first = std::min(count, capacity() - start);
+        std::move(slots.get() + start, slots.get() + start + first, values);
+        std::move(slots.get(), slots.get() + (count - first), values + first);
+        consumer.head.store(head + count, std::memory_order_release);
+        return count;
+    }
+
+private:
+    struct alignas(channel_detail::CACHE_LINE) Producer {
+        std::atomic<std::size_t> tail{0};   // Next slot to write
+        std::size_t cached_head = 0;        // Last head seen by the producer
+    };
+    struct alignas(channel_detail::CACHE_LINE) Consumer {
+        std::atomic<std::size_t> head{0};   // Next slot to read
+        std::size_t cached_tail = 0;        // Last tail seen by the consumer
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<T[]> slots;
+    Producer producer;
+    Consumer consumer;
+};
+
+// Multiple producers, single consumer, for fanning several threads in to
+// one. Each slot carries a sequence number saying whose turn it is, so
+// producers only contend on claiming a slot and never wait for each other
+// to finish writing (Vyukov's bounded queue). Values from one producer
+// arrive in the order it pushed them.
+template <typename T>
+class MpscChannel {
+public:
+    explicit MpscChannel(std::size_t capacity) :
+        mask(channel_detail::round_capacity(capacity) - 1),
+        slots(new Slot[mask + 1]) {
+        for (std::size_t i = 0; i <= mask; i++) {
+            slots[i].sequence.store(i, std::memory_order_relaxed);
+        }
+    }
+
+    MpscChannel(const MpscChannel&) = delete;
+    MpscChannel& operator=(const MpscChannel&) = delete;
+
+    std::size_t capacity() const { return mask + 1; }
+
+    // Number of values waiting. Exact only when no side is active. Read
+    // in the same order as SpscChannel::size(), for the same reason.
+    std::size_t size() const {
+        std::size_t first = head.load(std::memory_order_acquire);
+        std::size_t last = tail.load(std::memory_order_acquire);
+        return std::min(last - first, capacity());
+    }
+
+    // Producer side, any thread: add one value, or return false if full
+    bool try_push(const T& value) {
+        std::size_t position = tail.load(std::memory_order_relaxed);
+        Slot* slot;
+        for (;;) {
+            slot = &slots[position & mask];
+            std::size_t sequence = slot->sequence.load(std::memory_order_acquire);
+            std::ptrdiff_t ahead = (std::ptrdiff_t) (sequence - position);
+            if (ahead == 0) {
+                if (tail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                    break;
+                }
+            } else if (ahead < 0) {
+                return false;   // the slot still holds a value from the last lap
+            } else {
+                position = tail.load(std::memory_order_relaxed);
+            }
+        }
+        slot->value = value;
+        slot->sequence.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side: add up to n values and return how many fit. The
+    // slots are claimed with a single compare and swap, so a batch is not
+    // interleaved with other producers' values.
+    std::size_t push_n(const T* values, std::size_t n) {
+        std::size_t position = tail.load(std::memory_order_relaxed), count;
+        for (;;) {
+            // Slots before head have been read and released by the consumer
+            std::ptrdiff_t used = (std::ptrdiff_t) (position - head.load(std::memory_order_acquire));
+            if (used < 0) {
+                position = tail.load(std::memory_order_relaxed);   // stale position
+                continue;
+            }
+            // used can briefly exceed the capacity while the consumer is
+            // between releasing slots and publishing head
+            count = (std::size_t) used >= capacity() ? 0 : std::min(n, capacity() - (std::size_t) used);
+            if (count == 0) {
+                return 0;
+            }
+            if (tail.compare_exchange_weak(position, position + count, std::memory_order_relaxed)) {
+                break;
+            }
+        }
+        for (std::size_t i = 0; i < count; i++) {
+            Slot& slot = slots[(position + i) & mask];
+            slot.value = values[i];
+            slot.sequence.store(position + i + 1, std::memory_order_release);
+        }
+        return count;
+    }
+
+    // Consumer side, one thread only: take one value, or return false if
+    // none is ready
+    bool try_pop(T& value) {
+        std::size_t position = head.load(std::memory_order_relaxed);
+        Slot& slot = slots[position & mask];
+        if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+            return false;
+        }
+        value = std::move(slot.value);
+        slot.sequence.store(position + capacity(), std::memory_order_release);
+        head.store(position + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side: take up to n ready values, oldest first
+    std::size_t pop_n(T* values, std::size_t n) {
+        std::size_t position = head.load(std::memory_order_relaxed), count = 0;
+        for (; count < n; count++, position++) {
+            Slot& slot = slots[position & mask];
+            if (slot.sequence.load(std::memory_order_acquire) != position + 1) {
+                break;
+            }
+            values[count] = std::move(slot.value);
+            slot.sequence.store(position + capacity(), std::memory_order_release);
+        }
+        head.store(position, std::memory_order_release);
+        return count;
+    }
+
+private:
+    struct Slot {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    const std::size_t mask;
+    std::unique_ptr<Slot[]> slots;
+    alignas(channel_detail::CACHE_LINE) std::atomic<std::size_t> tail{0};   // Next slot to claim
+    alignas(channel_detail::CACHE_LINE) std::atomic<std::size_t> head{0};   // Next slot to read
+};
+
+namespace channel_detail {
+
+    // Processes with a block update(const double*, n), like TypedFilter
+    template <typename P, typename = void>
+    struct has_block_update : std::false_type {};
+    template <typename P>
+    struct has_block_update<P, std::void_t<decltype(std::declval<P&>().update(
+        std::declval<const double*>(), std::size_t()))>> : std::true_type {};
+
+}
+
+// Feed the values waiting in a channel to a process, such as a Filter,
+// BATCH at a time. Processes with a block update get whole batches. Returns
+// the number of values consumed; stops early after max.
+template <typename Channel, typename Process>
+std::size_t consume(Channel& channel, Process& process, std::size_t max = (std::size_t) -1) {
+    const std::size_t BATCH = 256;
+    double buffer[BATCH];
+    std::size_t total = 0;
+    while (total < max) {
+        std::size_t count = channel.pop_n(buffer, std::min(BATCH, max - total));
+        if (count == 0) {
+            break;
+        }
+        if constexpr (channel_detail::has_block_update<Process>::value) {
+            process.update(buffer, count);
+        } else {
+            for (std::size_t i = 0; i < count; i++) {
+                process.update(buffer[i]);
+            }
+        }
+        total += count;
+    }
+    return total;
+}
+
+// Push the current value of a process, such as an Integrator, into a
+// channel. Returns false if the channel was full.
+template <typename Process, typename Channel>
+bool publish(const Process& process, Channel& channel) {
+    return channel.try_push(process.value());
+}
+
+#endif // CHANNEL_H
@@ -0,0 +1,198 @@
+#ifndef CONCURRENT_STOPWATCH_H
+#define CONCURRENT_STOPWATCH_H
+
+#include <atomic>
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "stopwatch.h"
+
+namespace concurrent_stopwatch_detail {
+
+    // A small index per live thread, reused after the thread exits, so
+    // per-thread slots can live in a fixed array
+    class ThreadIndex {
+    public:
+        static unsigned get() {
+            thread_local ThreadIndex index;
+            return index.value;
+        }
+
+    private:
+        unsigned value;
+
+        static std::mutex& mutex() {
+            static std::mutex m;
+            return m;
+        }
+        static std::vector<bool>& used() {
+            static std::vector<bool> u;
+            return u;
+        }
+
+        ThreadIndex() {
+            std::lock_guard<std::mutex> lock(mutex());
+            std::vector<bool>& u = used();
+            value = 0;
+            while (value < u.size() && u[value]) {
+                value++;
+            }
+            if (value == u.size()) {
+                u.push_back(true);
+            } else {
+                u[value] = true;
+            }
+        }
+
+        ~ThreadIndex() {
+            std::lock_guard<std::mutex> lock(mutex());
+            used()[value] = false;
+        }
+    };
+
+}
+
+// A stopwatch that many threads can record intervals into at once. Unlike
+// Stopwatch there is no shared running state: each thread times its own
+// intervals, with time() or start() and stop(), and adds them to the total.
+//
+// Each of the first SLOTS concurrent threads has a slot of its own on a
+// separate cache line. Recording into it is wait-free: the owning thread
+// is the only writer, and a sequence number around the update lets readers
+// take a consistent (total, count) pair without stopping it. Threads beyond
+// SLOTS share one more slot through atomic additions, which stay lock-free
+// but may be read mid-update, with the count one interval ahead of the total.
+template <typename ClockPolicy>
+class BasicConcurrentStopwatch {
+public:
+    typedef typename ClockPolicy::ticks ticks;
+    static constexpr unsigned SLOTS = 64;
+
+    // Totals at one moment
+    struct Snapshot {
+        ticks total;
+        std::uint64_t count;
+    };
+
+    // Times from construction to stop() or destruction
+    class Interval {
+    public:
+        explicit Interval(BasicConcurrentStopwatch& watch) : watch(&watch), started(ClockPolicy::now()) {}
+        ~Interval() { stop(); }
+        Interval(const Interval&) = delete;
+        Interval& operator=(const Interval&) = delete;
+
+        void stop() {
+            if (watch) {
+                watch->stop(started);
+                watch = nullptr;
+            }
+        }
+
+    private:
+        BasicConcurrentStopwatch* watch;
+        ticks started;
+    };
+
+    BasicConcurrentStopwatch() : baseline{0, 0} {}
+
+    BasicConcurrentStopwatch(const BasicConcurrentStopwatch&) = delete;
+    BasicConcurrentStopwatch& operator=(const BasicConcurrentStopwatch&) = delete;
+
+    // Time the caller's scope: auto interval = watch.time();
+    Interval time() {
+        return Interval(*this);
+    }
+
+    // Start an interval on the calling thread; pass the result to stop()
+    ticks start() const {
+        return ClockPolicy::now();
+    }
+
+    void stop(ticks started) {
+        add_ticks(ClockPolicy::now() - started);
+    }
+
+    // Add one interval measured some other way
+    void add_ticks(ticks interval) {
+        unsigned index = concurrent_stopwatch_detail::ThreadIndex::get();
+        if (index < SLOTS) {
+            Slot& slot = slots[index];
+            std::uint64_t sequence = slot.sequence.load(std::memory_order_relaxed);
+            slot.sequence.store(sequence + 1, std::memory_order_relaxed);
+            // Release stores, so a reader that sees either new value also
+            // sees the odd sequence number before it
+            slot.total.store(slot.total.load(std::memory_order_relaxed) + interval, std::memory_order_release);
+            slot.count.store(slot.count.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+            slot.sequence.store(sequence + 2, std::memory_order_release);
+        } else {
+            shared.total.fetch_add(interval, std::memory_order_relaxed);
+            shared.count.fetch_add(1, std::memory_order_relaxed);
+        }
+    }
+
+    // Totals of every interval recorded since construction or reset()
+    Snapshot snapshot() const {
+        std::lock_guard<std::mutex> lock(read_mutex);
+        Snapshot sum = raw_snapshot();
+        return Snapshot{sum.total - baseline.total, sum.count - baseline.count};
+    }
+
+    // Start counting from zero again. Intervals still being recorded by
+    // other threads may land on either side of the reset.
+    void reset() {
+        std::lock_guard<std::mutex> lock(read_mutex);
+        baseline = raw_snapshot();
+    }
+
+    std::uint64_t count() const { return snapshot().count; }
+    ticks get_ticks() const { return snapshot().total; }
+
+    std::chrono::nanoseconds get_duration() const {
+        return std::chrono::nanoseconds(ClockPolicy::to_nanoseconds(get_ticks()));
+    }
+
+    double get_minutes() const { return get_nanoseconds() / (60.0 * 1e9); }
+    double get_seconds() const { return get_nanoseconds() / 1e9; }
+    double get_milliseconds() const { return get_nanoseconds() / 1e6; }
+    double get_nanoseconds() const { return static_cast<double>(get_duration().count()); }
+
+private:
+    struct alignas(64) Slot {
+        std::atomic<std::uint64_t> sequence{0};   // Odd while the owner is writing
+        std::atomic<ticks> total{0};
+        std::atomic<std::uint64_t> count{0};
+    };
+
+    Slot slots[SLOTS];
+    Slot shared;                     // Threads beyond SLOTS
+    mutable std::mutex read_mutex;   // Serializes readers with reset(), never taken by writers
+    Snapshot baseline;
+
+    Snapshot raw_snapshot() const {
+        Snapshot sum{0, 0};
+        for (const Slot& slot : slots) {
+            std::uint64_t before, after;
+            ticks total;
+            std::uint64_t count;
+            do {
+                before = slot.sequence.load(std::memory_order_acquire);
+                total = slot.total.load(std::memory_order_acquire);
+                count = slot.count.load(std::memory_order_acquire);
+                after = slot.sequence.load(std::memory_order_relaxed);
+            } while (before != after || (before & 1));
+            sum.total += total;
+            sum.count += count;
+        }
+        sum.total += shared.total.load(std::memory_order_relaxed);
+        sum.count += shared.count.load(std::memory_order_relaxed);
+        return sum;
+    }
+};
+
+typedef BasicConcurrentStopwatch<SteadyClock> ConcurrentStopwatch;
+typedef BasicConcurrentStopwatch<TscClock> TscConcurrentStopwatch;
+
+#endif // CONCURRENT_STOPWATCH_H
@@ -0,0 +1,47 @@
+#ifndef EMA_FILTER_H
+#define EMA_FILTER_H
+
+#include <stdexcept>
+#include <string>
+
+// Exponential moving average: each new value moves the average a fraction
+// alpha of the way towards it. Constant time and memory, no history. The
+// first value initializes the average.
+class EmaFilter {
+private:
+    std::string name;
+    double alpha;           // Weight of the newest value, in (0, 1]
+    double average;         // Current smoothed value
+    bool first_update;
+
+public:
+    // Constructor
+    EmaFilter(std::string process_name, double alpha) :
+        name(process_name), alpha(alpha), average(0.0), first_update(true) {
+        if (!(alpha > 0.0 && alpha <= 1.0)) {
+            throw std::invalid_argument("EMA weight must be in (0, 1]");
+        }
+    }
+
+    // Process a new input value
+    void update(double input_value) {
+        if (first_update) {
+            average = input_value;
+            first_update = false;
+        } else {
+            average += alpha * (input_value - average);
+        }
+    }
+
+    // Get the name of the process
+    std::string get_name() const {
+        return name;
+    }
+
+    // Return the current average
+    double value() const {
+        return average;
+    }
+};
+
+#endif // EMA_FILTER_H
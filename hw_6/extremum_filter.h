@@ -0,0 +1,77 @@
+#ifndef EXTREMUM_FILTER_H
+#define EXTREMUM_FILTER_H
+
+#include <cstddef>
+#include <functional>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Minimum (or maximum) of the last `window` values in amortized O(1).
+//
+// A monotonic deque keeps only the values that can still become the
+// extremum: each new value first drops every older value it beats, since
+// those will leave the window before it does. The front of the deque is
+// then the extremum of the window. The deque never holds more than window
+// entries, so it lives in a fixed circular buffer and never allocates after
+// construction.
+template <typename Compare>
+class ExtremumFilter {
+private:
+    struct Entry {
+        std::size_t index;      // Position of the value in the input stream
+        double value;
+    };
+
+    std::string name;
+    std::vector<Entry> deque;   // Circular buffer holding the monotonic deque
+    std::size_t head;           // Slot of the front entry
+    std::size_t size;           // Number of entries in the deque
+    std::size_t seen;           // Number of values processed so far
+    Compare beats;
+
+    std::size_t slot(std::size_t i) const {
+        std::size_t s = head + i;
+        return s < deque.size() ? s : s - deque.size();
+    }
+
+public:
+    // Constructor
+    ExtremumFilter(std::string process_name, std::size_t window) :
+        name(process_name), deque(window), head(0), size(0), seen(0) {
+        if (window == 0) {
+            throw std::invalid_argument("Window size must be positive");
+        }
+    }
+
+    // Process a new input value
+    void update(double input_value) {
+        // Drop values the new one beats (or ties) from the back
+        while (size > 0 && !beats(deque[slot(size - 1)].value, input_value)) {
+            size--;
+        }
+        // Drop the front if it has left the window
+        if (size > 0 && seen - deque[head].index >= deque.size()) {
+            head = slot(1);
+            size--;
+        }
+        deque[slot(size)] = Entry{seen, input_value};
+        size++;
+        seen++;
+    }
+
+    // Get the name of the process
+    std::string get_name() const {
+        return name;
+    }
+
+    // Return the extremum of the window, or zero before the first value
+    double value() const {
+        return size == 0 ? 0.0 : deque[head].value;
+    }
+};
+
+typedef ExtremumFilter<std::less<double>> MinFilter;
+typedef ExtremumFilter<std::greater<double>> MaxFilter;
+
+#endif // EXTREMUM_FILTER_H
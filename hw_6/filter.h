@@ -1,46 +1,220 @@
 #ifndef FILTER_H
 #define FILTER_H
 
-#include <deque>
+#include <algorithm>
+#include <cstddef>
+#include <stdexcept>
 #include <string>
+#include <type_traits>
 #include <vector>
+#include "prefix_sum.h"
+#include "ring_view.h"
+
+// Window size meaning "chosen at run time, in the constructor"
+constexpr std::size_t DYNAMIC_WINDOW = 0;
+
+namespace filter_detail {
+
+    // Storage for a window fixed at compile time
+    template <typename T, std::size_t N>
+    class Window {
+    public:
+        Window(std::size_t window) {
+            if (window != N) {
+                throw std::invalid_argument("Window size does not match the filter type");
+            }
+        }
+        static constexpr std::size_t size() { return N; }
+        T& operator[](std::size_t i) { return values[i]; }
+        const T& operator[](std::size_t i) const { return values[i]; }
+        T* data() { return values; }
+        const T* data() const { return values; }
+    private:
+        T values[N];
+    };
+
+    // Storage for a window chosen at run time
+    template <typename T>
+    class Window<T, DYNAMIC_WINDOW> {
+    public:
+        Window(std::size_t window) : values(window) {
+            if (window == 0) {
+                throw std::invalid_argument("Window size must be positive");
+            }
+        }
+        std::size_t size() const { return values.size(); }
+        T& operator[](std::size_t i) { return values[i]; }
+        const T& operator[](std::size_t i) const { return values[i]; }
+        T* data() { return values.data(); }
+        const T* data() const { return values.data(); }
+    private:
+        std::vector<T> values;
+    };
+
+}
+
+// Moving average over the last N samples of type T. With N fixed at compile
+// time the window lives inside the object and the wrap-around is a compare
+// against a constant; with N = DYNAMIC_WINDOW the size is passed to the
+// constructor instead. Narrow sample types such as float or fixed point
+// integers halve the memory traffic of the window; sums are accumulated in
+// double or long long regardless.
+//
+// The running sum of floating point samples picks up rounding error each
+// time a value is added and another removed, so it is recomputed exactly
+// from the window every time the write position wraps around. That bounds
+// the drift to what one window's worth of updates can accumulate, at an
+// amortized cost of one addition per update.
+template <typename T, std::size_t N>
+class TypedFilter {
+public:
+    static constexpr std::size_t WINDOW = N;   // Compile-time window, or DYNAMIC_WINDOW
 
-class Filter {
 private:
     std::string name;
-    std::deque<double> values;  // Stores the last 10 values
-    double running_avg;         // Running average of the values
+    filter_detail::Window<T, N> values;       // Circular buffer of the last values
+    std::size_t next;                         // Slot the next value will be written to
+    std::size_t count;                        // Number of values currently stored
 
-    // Update the running average
-    void update_average() {
-        if (values.empty()) {
-            running_avg = 0.0;
-            return;
+    typedef typename std::conditional<std::is_floating_point<T>::value, double, long long>::type Accumulator;
+    Accumulator sum;                          // Running sum of the stored values
+
+    // Recompute the sum of a full window from scratch
+    void renormalize() {
+        sum = exact_sum(values.data(), values.size());
+    }
+
+    // Sum of n values, with four independent partial sums so the additions
+    // are not one long dependency chain
+    static Accumulator exact_sum(const T* x, std::size_t n) {
+        Accumulator s0 = 0, s1 = 0, s2 = 0, s3 = 0;
+        std::size_t i = 0;
+        for (; i + 4 <= n; i += 4) {
+            s0 += x[i];
+            s1 += x[i + 1];
+            s2 += x[i + 2];
+            s3 += x[i + 3];
         }
-        
-        double sum = 0.0;
-        for (double val : values) {
-            sum += val;
+        for (; i < n; i++) {
+            s0 += x[i];
         }
-        running_avg = sum / values.size();
+        return (s0 + s1) + (s2 + s3);
     }
 
 public:
-    // Constructor
-    Filter(std::string process_name) : name(process_name), running_avg(0.0) {}
+    // Constructor. The window argument is only needed for DYNAMIC_WINDOW.
+    TypedFilter(std::string process_name, std::size_t window = N) :
+        name(process_name), values(window), next(0), count(0), sum(0) {}
+
+    // Process a new input value in constant time: the oldest value is
+    // subtracted from the running sum and the new one added
+    void update(T input_value) {
+        if (count == values.size()) {
+            sum += (Accumulator) input_value - (Accumulator) values[next];
+        } else {
+            sum += input_value;
+            count++;
+        }
+        values[next] = input_value;
+        if (++next == values.size()) {
+            next = 0;
+            if (std::is_floating_point<T>::value) {
+                renormalize();
+            }
+        }
+    }
+
+    // Process a block of n input values. If output is not null, output[i]
+    // receives the moving average after input[i], exactly as if update()
+    // had been called for each value in turn.
+    //
+    // Once the window is full the averages come from a prefix sum of
+    // differences, out[i] = out[i-1] + (input[i] - input[i-w]) / w, where
+    // the differences are computed in a vectorizable pass over the block.
+    // Without an output only the last w values matter, so they are copied
+    // straight into the window.
+    void update(const T* input, std::size_t n, double* output = nullptr) {
+        std::size_t i = 0;
+
+        // Fill the window one value at a time
+        for (; i < n && count < values.size(); i++) {
+            update(input[i]);
+            if (output) {
+                output[i] = value();
+            }
+        }
+        if (i == n) {
+            return;
+        }
+
+        const std::size_t w = values.size(),
+                          m = n - i;
+        const T* x = input + i;
+
+        if (!output) {
+            if (m < w) {
+                for (std::size_t j = 0; j < m; j++) {
+                    update(x[j]);
+                }
+            } else {
+                std::copy(x + m - w, x + m, values.data());
+                next = 0;
+                renormalize();
+            }
+            return;
+        }
+
+        double* out = output + i;
+
+        // Differences between each new value and the one it evicts. The
+        // first w evict values from the window, the rest evict earlier
+        // values of this block.
+        std::size_t head = std::min(m, w),
+                    wrap = std::min(head, w - next);
+        const T* ring = values.data();
+        for (std::size_t j = 0; j < wrap; j++) {
+            out[j] = (double) x[j] - (double) ring[next + j];
+        }
+        for (std::size_t j = wrap; j < head; j++) {
+            out[j] = (double) x[j] - (double) ring[j - wrap];
+        }
+        for (std::size_t j = w; j < m; j++) {
+            out[j] = (double) x[j] - (double) x[j - w];
+        }
+
+        // Running sum of the differences. Long blocks re-sum the current
+        // window exactly now and then so rounding error cannot build up.
+        const std::size_t interval = std::max<std::size_t>(4 * w, 4096);
+        const double scale = 1.0 / w;
+        double s = (double) sum;
+        for (std::size_t start = 0; start < m; start += interval) {
+            std::size_t end = std::min(m, start + interval);
+            s = prefix_sum(out + start, end - start, s, scale);
+            if (end < m && end >= w) {
+                s = (double) exact_sum(x + end - w, w);
+            }
+        }
 
-    // Process a new input value
-    void update(double input_value) {
-        // Add the new value to our collection
-        values.push_back(input_value);
-        
-        // Keep only the last 10 values
-        if (values.size() > 10) {
-            values.pop_front();
+        // Leave the last w values in the window
+        std::size_t slot = (next + m - head) % w;
+        for (std::size_t j = m - head; j < m; j++) {
+            values[slot] = x[j];
+            if (++slot == w) {
+                slot = 0;
+            }
         }
-        
-        // Update the running average
-        update_average();
+        next = slot;
+        renormalize();
+    }
+
+    void update(const std::vector<T>& input) {
+        update(input.data(), input.size());
+    }
+
+    // Block update that also returns the average after every value
+    void update(const std::vector<T>& input, std::vector<double>& output) {
+        output.resize(input.size());
+        update(input.data(), input.size(), output.data());
     }
 
     // Get the name of the process
@@ -50,13 +224,22 @@ public:
 
     // Return the current running average
     double value() const {
-        return running_avg;
+        return count == 0 ? 0.0 : (double) sum / count;
     }
 
-    // Get the values in the filter
-    const std::deque<double>& get_values() const {
-        return values;
+    // Number of values averaged once the window is full
+    std::size_t window() const {
+        return values.size();
+    }
+
+    // Get the values in the filter, oldest first
+    RingView<T> get_values() const {
+        std::size_t first = count == values.size() ? next : 0;
+        return RingView<T>(values.data(), values.size(), first, count);
     }
 };
 
-#endif // FILTER_H
\ No newline at end of file
+typedef TypedFilter<double, 10> Filter;
+typedef TypedFilter<double, DYNAMIC_WINDOW> DynamicFilter;
+
+#endif // FILTER_H
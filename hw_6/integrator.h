@@ -3,46 +3,71 @@
 
 #include <string>
 #include <chrono>
+#include <stdexcept>
+
+// Quadrature rule used between successive samples
+enum class IntegrationRule {
+    Rectangle,      // value * dt, using the newest value (first order)
+    Trapezoidal,    // average of the two endpoint values * dt (second order)
+    Simpson         // Simpson's rule over pairs of intervals (fourth order)
+};
+
+// Integrates a signal over time. Each update supplies a value and the time
+// it was sampled at, either explicitly or read from Clock. Passing explicit
+// timestamps makes the result independent of call timing and lets recorded
+// data be replayed; Clock can be any std::chrono style clock, including a
+// fake one in tests.
+template <typename Clock>
+class BasicIntegrator {
+public:
+    typedef typename Clock::time_point time_point;
 
-class Integrator {
 private:
     std::string name;
+    IntegrationRule rule;
     double integrated_value;  // Stores the current integral value
-    std::chrono::time_point<std::chrono::high_resolution_clock> last_update_time;
+    time_point last_update_time;
+    double last_value;        // Value at last_update_time
     bool first_update;
 
+    // Simpson's rule needs three samples, so every other interval is held
+    // back until the next one completes the pair
+    bool pair_open;
+    double pair_value;        // Value at the start of the open pair
+    double pair_width;        // Length of the first interval of the pair
+    double pending;           // Trapezoidal estimate of the open interval
+
 public:
     // Constructor
-    Integrator(std::string process_name) : 
-        name(process_name), 
+    BasicIntegrator(std::string process_name, IntegrationRule rule = IntegrationRule::Rectangle) :
+        name(process_name),
+        rule(rule),
         integrated_value(0.0),
-        first_update(true) {}
+        last_value(0.0),
+        first_update(true),
+        pair_open(false),
+        pair_value(0.0),
+        pair_width(0.0),
+        pending(0.0) {}
 
-    // Process a new input value with the elapsed time since last update
+    // Process a new input value sampled now. If Clock steps backwards (the
+    // system clock can, under NTP or a manual change) the interval counts
+    // as zero rather than throwing.
     void update(double input_value) {
-        auto current_time = std::chrono::high_resolution_clock::now();
-        
-        if (first_update) {
-            // Initialize the last update time on first call
-            last_update_time = current_time;
-            first_update = false;
-            return;
-        }
-        
-        // Calculate time difference in seconds
-        std::chrono::duration<double> delta = current_time - last_update_time;
-        double delta_seconds = delta.count();
-        
-        // Numerical integration: add delta * input_value to the integrated value
-        integrated_value += delta_seconds * input_value;
-        
-        // Update the last update time
-        last_update_time = current_time;
+        advance(input_value, Clock::now(), false);
+    }
+
+    // Process a new input value sampled at the given time, which must not
+    // be earlier than the previous one
+    void update(double input_value, time_point current_time) {
+        advance(input_value, current_time, true);
     }
 
     // Reset the integrator
     void reset() {
         integrated_value = 0.0;
+        pending = 0.0;
+        pair_open = false;
         first_update = true;
     }
 
@@ -51,10 +76,76 @@ public:
         return name;
     }
 
-    // Return the current integrated value
+    IntegrationRule get_rule() const {
+        return rule;
+    }
+
+    // Return the current integrated value. With Simpson's rule an unpaired
+    // last interval is included with the trapezoidal rule.
     double value() const {
-        return integrated_value;
+        return integrated_value + pending;
+    }
+
+private:
+    // Add the interval ending at current_time. A decreasing timestamp
+    // throws when strict, and is otherwise a zero-width interval.
+    void advance(double input_value, time_point current_time, bool strict) {
+        if (first_update) {
+            // Initialize the last update time on first call
+            last_update_time = current_time;
+            last_value = input_value;
+            first_update = false;
+            return;
+        }
+
+        // Calculate time difference in seconds
+        std::chrono::duration<double> delta = current_time - last_update_time;
+        double dt = delta.count();
+        if (dt < 0) {
+            if (strict) {
+                throw std::invalid_argument("Integrator timestamps must not decrease");
+            }
+            dt = 0;
+        }
+
+        switch (rule) {
+            case IntegrationRule::Rectangle:
+                integrated_value += dt * input_value;
+                break;
+            case IntegrationRule::Trapezoidal:
+                integrated_value += dt * (last_value + input_value) / 2;
+                break;
+            case IntegrationRule::Simpson:
+                add_simpson(input_value, dt);
+                break;
+        }
+
+        last_update_time = current_time;
+        last_value = input_value;
+    }
+
+    void add_simpson(double input_value, double dt) {
+        if (dt == 0) {
+            return;   // zero-width interval: nothing to add
+        }
+        if (!pair_open) {
+            pair_open = true;
+            pair_value = last_value;
+            pair_width = dt;
+            pending = dt * (last_value + input_value) / 2;
+            return;
+        }
+        // Simpson's rule for unequal widths h0, h1 through f0, f1, f2
+        double h0 = pair_width, h1 = dt,
+               f0 = pair_value, f1 = last_value, f2 = input_value;
+        integrated_value += (h0 + h1) / 6 * ((2 - h1 / h0) * f0
+                                             + (h0 + h1) * (h0 + h1) / (h0 * h1) * f1
+                                             + (2 - h0 / h1) * f2);
+        pair_open = false;
+        pending = 0.0;
     }
 };
 
-#endif // INTEGRATOR_H
\ No newline at end of file
+typedef BasicIntegrator<std::chrono::high_resolution_clock> Integrator;
+
+#endif // INTEGRATOR_H
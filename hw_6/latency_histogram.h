@@ -0,0 +1,135 @@
+#ifndef LATENCY_HISTOGRAM_H
+#define LATENCY_HISTOGRAM_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+
+// Histogram of durations in integer nanoseconds with bounded relative error,
+// in the style of HdrHistogram. Values below 2^SUB_BUCKET_BITS get a bucket
+// each; above that every power of two is split into 2^SUB_BUCKET_BITS equal
+// buckets, so a value is known to within 1/64 (1.6%) of itself across the
+// whole 64 bit range. The counts live in a fixed array: recording is an
+// index computation and an increment, and never allocates.
+class LatencyHistogram {
+public:
+    static constexpr unsigned SUB_BUCKET_BITS = 6;
+    static constexpr std::size_t SUB_BUCKETS = std::size_t(1) << SUB_BUCKET_BITS;
+    static constexpr std::size_t BUCKETS = (65 - SUB_BUCKET_BITS) * SUB_BUCKETS;
+
+    LatencyHistogram() {
+        reset();
+    }
+
+    // Bucket holding value
+    static constexpr std::size_t bucket_index(std::uint64_t value) {
+        if (value < SUB_BUCKETS) {
+            return (std::size_t) value;
+        }
+        unsigned exponent = 63 - (unsigned) __builtin_clzll(value);
+        unsigned shift = exponent - SUB_BUCKET_BITS;
+        return (std::size_t) (shift + 1) * SUB_BUCKETS + (std::size_t) ((value >> shift) - SUB_BUCKETS);
+    }
+
+    // Smallest and largest values that fall in a bucket
+    static constexpr std::uint64_t bucket_low(std::size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        unsigned shift = (unsigned) (index / SUB_BUCKETS) - 1;
+        return (std::uint64_t) (index % SUB_BUCKETS + SUB_BUCKETS) << shift;
+    }
+
+    static constexpr std::uint64_t bucket_high(std::size_t index) {
+        if (index < SUB_BUCKETS) {
+            return index;
+        }
+        unsigned shift = (unsigned) (index / SUB_BUCKETS) - 1;
+        return bucket_low(index) + ((std::uint64_t(1) << shift) - 1);
+    }
+
+    void record(std::uint64_t nanoseconds) {
+        counts[bucket_index(nanoseconds)]++;
+        total_count++;
+        sum += nanoseconds;
+        smallest = std::min(smallest, nanoseconds);
+        largest = std::max(largest, nanoseconds);
+    }
+
+    // Record the same value several times
+    void record(std::uint64_t nanoseconds, std::uint64_t times) {
+        if (times == 0) {
+            return;
+        }
+        counts[bucket_index(nanoseconds)] += times;
+        total_count += times;
+        sum += nanoseconds * times;
+        smallest = std::min(smallest, nanoseconds);
+        largest = std::max(largest, nanoseconds);
+    }
+
+    // Add the counts of another histogram to this one
+    void merge(const LatencyHistogram& other) {
+        for (std::size_t i = 0; i < BUCKETS; i++) {
+            counts[i] += other.counts[i];
+        }
+        total_count += other.total_count;
+        sum += other.sum;
+        smallest = std::min(smallest, other.smallest);
+        largest = std::max(largest, other.largest);
+    }
+
+    void reset() {
+        std::fill(counts, counts + BUCKETS, 0);
+        total_count = 0;
+        sum = 0;
+        smallest = std::numeric_limits<std::uint64_t>::max();
+        largest = 0;
+    }
+
+    std::uint64_t count() const { return total_count; }
+    std::uint64_t min() const { return total_count ? smallest : 0; }   // Exact
+    std::uint64_t max() const { return largest; }                      // Exact
+    double mean() const { return total_count ? (double) sum / total_count : 0.0; }
+
+    // Value at or below which the given percentage of the recorded values
+    // lie, reported as the top of its bucket (and never above max())
+    std::uint64_t percentile(double percent) const {
+        if (!(percent >= 0.0 && percent <= 100.0)) {
+            throw std::invalid_argument("Percentile must be between 0 and 100");
+        }
+        if (total_count == 0) {
+            return 0;
+        }
+        std::uint64_t rank = (std::uint64_t) (percent / 100.0 * total_count + 0.5);
+        rank = std::max<std::uint64_t>(rank, 1);
+        std::uint64_t seen = 0;
+        for (std::size_t i = 0; i < BUCKETS; i++) {
+            seen += counts[i];
+            if (seen >= rank) {
+                return std::min(bucket_high(i), largest);
+            }
+        }
+        return largest;
+    }
+
+    std::uint64_t p50() const { return percentile(50.0); }
+    std::uint64_t p90() const { return percentile(90.0); }
+    std::uint64_t p99() const { return percentile(99.0); }
+    std::uint64_t p999() const { return percentile(99.9); }
+
+    // Number of values recorded in a bucket
+    std::uint64_t bucket_count(std::size_t index) const {
+        return index < BUCKETS ? counts[index] : 0;
+    }
+
+private:
+    std::uint64_t counts[BUCKETS];
+    std::uint64_t total_count;
+    std::uint64_t sum;
+    std::uint64_t smallest, largest;
+};
+
+#endif // LATENCY_HISTOGRAM_H
@@ -0,0 +1,93 @@
+#ifndef MEDIAN_FILTER_H
+#define MEDIAN_FILTER_H
+
+#include <cstddef>
+#include <iterator>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+// Median of the last `window` values, in O(log window) per update.
+//
+// The window is split into two ordered halves: `low` holds the smaller
+// values and `high` the larger ones, with low never more than one element
+// bigger than high. The median is then the largest element of low, or the
+// mean of the two middle elements when the window has an even size.
+class MedianFilter {
+private:
+    std::string name;
+    std::vector<double> values;     // Circular buffer of the window, for eviction
+    std::size_t next;               // Slot the next value will be written to
+    std::size_t count;              // Number of values currently stored
+    std::multiset<double> low,      // Smaller half of the window
+                          high;     // Larger half of the window
+
+    // Restore low.size() == high.size() or high.size() + 1
+    void rebalance() {
+        if (low.size() > high.size() + 1) {
+            auto largest = std::prev(low.end());
+            high.insert(*largest);
+            low.erase(largest);
+        } else if (high.size() > low.size()) {
+            auto smallest = high.begin();
+            low.insert(*smallest);
+            high.erase(smallest);
+        }
+    }
+
+public:
+    // Constructor
+    MedianFilter(std::string process_name, std::size_t window) :
+        name(process_name), values(window), next(0), count(0) {
+        if (window == 0) {
+            throw std::invalid_argument("Window size must be positive");
+        }
+    }
+
+    // Process a new input value
+    void update(double input_value) {
+        if (count == values.size()) {
+            // Every element of high is >= the largest of low, so the evicted
+            // value is in low whenever it is not above that largest element
+            double old = values[next];
+            if (old <= *low.rbegin()) {
+                low.erase(low.find(old));
+            } else {
+                high.erase(high.find(old));
+            }
+        } else {
+            count++;
+        }
+
+        if (low.empty() || input_value <= *low.rbegin()) {
+            low.insert(input_value);
+        } else {
+            high.insert(input_value);
+        }
+        rebalance();
+
+        values[next] = input_value;
+        if (++next == values.size()) {
+            next = 0;
+        }
+    }
+
+    // Get the name of the process
+    std::string get_name() const {
+        return name;
+    }
+
+    // Return the median of the window, or zero before the first value
+    double value() const {
+        if (count == 0) {
+            return 0.0;
+        }
+        if (low.size() > high.size()) {
+            return *low.rbegin();
+        }
+        return (*low.rbegin() + *high.begin()) / 2.0;
+    }
+};
+
+#endif // MEDIAN_FILTER_H
@@ -0,0 +1,42 @@
+#ifndef PREFIX_SUM_H
+#define PREFIX_SUM_H
+
+#include <cstddef>
+
+// Replaces d[0..n) by its running sums (start + d[0] + ... + d[i]) * scale
+// and returns the final unscaled running sum.
+//
+// A running sum is one long chain of dependent additions, so instead the
+// range is scanned as four independent quarters interleaved in one loop,
+// and each quarter's offset is added in a second pass that the compiler can
+// vectorize. The additions happen in a different order than a serial scan,
+// so results can differ from it in the last bits.
+inline double prefix_sum(double* d, std::size_t n, double start = 0.0, double scale = 1.0) {
+    std::size_t q = n / 4;
+    double *d0 = d, *d1 = d + q, *d2 = d + 2 * q, *d3 = d + 3 * q;
+    double a0 = 0, a1 = 0, a2 = 0, a3 = 0;
+    for (std::size_t j = 0; j < q; j++) {
+        a0 += d0[j]; d0[j] = a0;
+        a1 += d1[j]; d1[j] = a1;
+        a2 += d2[j]; d2[j] = a2;
+        a3 += d3[j]; d3[j] = a3;
+    }
+    for (std::size_t j = q; j < n - 3 * q; j++) {
+        a3 += d3[j]; d3[j] = a3;
+    }
+    double o0 = start,
+           o1 = o0 + a0,
+           o2 = o1 + a1,
+           o3 = o2 + a2;
+    for (std::size_t j = 0; j < q; j++) {
+        d0[j] = (d0[j] + o0) * scale;
+        d1[j] = (d1[j] + o1) * scale;
+        d2[j] = (d2[j] + o2) * scale;
+    }
+    for (std::size_t j = 0; j < n - 3 * q; j++) {
+        d3[j] = (d3[j] + o3) * scale;
+    }
+    return o3 + a3;
+}
+
+#endif // PREFIX_SUM_H
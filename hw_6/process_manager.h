@@ -0,0 +1,332 @@
+#ifndef PROCESS_MANAGER_H
+#define PROCESS_MANAGER_H
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <type_traits>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "trace.h"
+
+// Snapshot of how a managed process has been running
+struct ProcessStats {
+    std::string name;
+    std::chrono::nanoseconds period;
+    std::uint64_t updates;                    // Number of completed updates
+    std::uint64_t overruns;                   // Releases skipped because an update ran late
+    std::chrono::nanoseconds last_latency;    // Duration of the latest update
+    std::chrono::nanoseconds average_latency; // Mean duration of all updates
+    bool failed;                              // An update threw; see ProcessManager::error()
+};
+
+namespace process_manager_detail {
+
+    // Processes with update() take no input, like RandomProcess
+    template <typename P, typename = void>
+    struct is_source : std::false_type {};
+    template <typename P>
+    struct is_source<P, std::void_t<decltype(std::declval<P&>().update())>> : std::true_type {};
+
+    // Output is latest() where there is one, value() otherwise
+    template <typename P, typename = void>
+    struct has_latest : std::false_type {};
+    template <typename P>
+    struct has_latest<P, std::void_t<decltype(std::declval<const P&>().latest())>> : std::true_type {};
+
+    template <typename P>
+    double output_of(const P& process) {
+        if constexpr (has_latest<P>::value) {
+            return process.latest();
+        } else {
+            return process.value();
+        }
+    }
+
+}
+
+// Runs processes periodically on a pool of worker threads. Processes are
+// registered with a period and run at every multiple of it after start();
+// the worker pool always runs the process with the earliest deadline next.
+//
+// Any of the hw_6 process classes can be added directly: sources such as
+// RandomProcess are updated with no input, and filters and integrators are
+// updated with the latest output of the process connected to them. The
+// manager does not own the processes, which must outlive it. A process is
+// never updated by two threads at once, but different processes run
+// concurrently, so processes must not share unsynchronized state.
+//
+// If an update finishes after its process's next release time, the missed
+// releases are skipped and counted as overruns rather than run back to back.
+//
+// An exception thrown by an update is caught on the worker. The process is
+// then no longer scheduled, the others keep running, and the exception is
+// kept for error() until the next start().
+//
+// While tracing is enabled (trace.h) every update is recorded as a trace
+// event named after its process, on a thread named after its worker.
+class ProcessManager {
+public:
+    typedef std::chrono::steady_clock clock;
+    typedef std::function<double(double)> Step;   // Input to output
+
+private:
+    struct Task {
+        std::string name;
+        const char* trace_name;                // The name, interned for trace events
+        std::chrono::nanoseconds period;
+        Step step;
+        std::atomic<double> output{0.0};
+        const Task* input = nullptr;           // Process whose output feeds this one
+        clock::time_point deadline;            // Next release
+        std::atomic<std::uint64_t> updates{0}, overruns{0};
+        std::atomic<std::int64_t> last_latency{0}, total_latency{0};   // Nanoseconds
+        std::atomic<bool> failed{false};
+        std::exception_ptr error;              // What the failed update threw; guarded by mutex
+    };
+
+    // Heap entry: the earliest deadline is on top
+    struct Release {
+        clock::time_point deadline;
+        Task* task;
+        bool operator<(const Release& other) const { return deadline > other.deadline; }
+    };
+
+    std::vector<std::unique_ptr<Task>> tasks;
+    std::unordered_map<std::string, Task*> by_name;
+    std::priority_queue<Release> queue;
+    mutable std::mutex mutex;
+    std::condition_variable wake;
+    std::vector<std::thread> workers;
+    bool running;
+
+    Task& find(const std::string& name) {
+        auto it = by_name.find(name);
+        if (it == by_name.end()) {
+            throw std::invalid_argument("No process named " + name);
+        }
+        return *it->second;
+    }
+
+    const Task& find(const std::string& name) const {
+        return const_cast<ProcessManager*>(this)->find(name);
+    }
+
+    void require_stopped() const {
+        if (running) {
+            throw std::logic_error("Processes cannot be changed while the manager is running");
+        }
+    }
+
+    void work(unsigned index) {
+        TraceRecorder::instance().set_thread_name("worker " + std::to_string(index));
+        std::unique_lock<std::mutex> lock(mutex);
+        while (running) {
+            if (queue.empty()) {
+                wake.wait(lock);
+                continue;
+            }
+            Release next = queue.top();
+            if (clock::now() < next.deadline) {
+                wake.wait_until(lock, next.deadline);
+                continue;
+            }
+            queue.pop();
+            lock.unlock();
+
+            Task& task = *next.task;
+            double input = task.input ? task.input->output.load(std::memory_order_acquire) : 0.0;
+            clock::time_point started = clock::now();
+            try {
+                task.output.store(task.step(input), std::memory_order_release);
+            } catch (...) {
+                // Keep the exception and drop the process from the schedule
+                lock.lock();
+                task.error = std::current_exception();
+                task.failed.store(true, std::memory_order_relaxed);
+                continue;
+            }
+            clock::time_point finished = clock::now();
+
+            std::int64_t latency = std::chrono::duration_cast<std::chrono::nanoseconds>(finished - started).count();
+            task.last_latency.store(latency, std::memory_order_relaxed);
+            task.total_latency.fetch_add(latency, std::memory_order_relaxed);
+            task.updates.fetch_add(1, std::memory_order_relaxed);
+            TraceRecorder::instance().record(task.trace_name,
+                std::chrono::duration_cast<std::chrono::nanoseconds>(started.time_since_epoch()).count(),
+                std::chrono::duration_cast<std::chrono::nanoseconds>(finished.time_since_epoch()).count());
+
+            // Next release, skipping any that have already passed
+            clock::time_point deadline = next.deadline + task.period;
+            if (finished > deadline) {
+                auto missed = (finished - deadline) / task.period + 1;
+                task.overruns.fetch_add(missed, std::memory_order_relaxed);
+                deadline += missed * task.period;
+            }
+
+            lock.lock();
+            task.deadline = deadline;
+            queue.push(Release{deadline, &task});
+            wake.notify_one();
+        }
+    }
+
+public:
+    ProcessManager() : running(false) {}
+
+    ~ProcessManager() {
+        stop();
+    }
+
+    ProcessManager(const ProcessManager&) = delete;
+    ProcessManager& operator=(const ProcessManager&) = delete;
+
+    // Register a function of the connected input, run every period
+    void add(const std::string& name, std::chrono::nanoseconds period, Step step) {
+        require_stopped();
+        if (period <= std::chrono::nanoseconds::zero()) {
+            throw std::invalid_argument("Process period must be positive");
+        }
+        if (by_name.count(name)) {
+            throw std::invalid_argument("A process named " + name + " already exists");
+        }
+        tasks.emplace_back(new Task);
+        Task& task = *tasks.back();
+        task.name = name;
+        task.trace_name = TraceRecorder::instance().intern(name);
+        task.period = period;
+        task.step = std::move(step);
+        by_name[name] = &task;
+    }
+
+    // Register one of the process classes under its own name
+    template <typename P>
+    void add(P& process, std::chrono::nanoseconds period) {
+        P* p = &process;
+        if constexpr (process_manager_detail::is_source<P>::value) {
+            add(process.get_name(), period, [p](double) {
+                p->update();
+                return process_manager_detail::output_of(*p);
+            });
+        } else {
+            add(process.get_name(), period, [p](double input) {
+                p->update(input);
+                return process_manager_detail::output_of(*p);
+            });
+        }
+    }
+
+    // Feed the output of one process into another. The receiver sees the
+    // latest output at the time it runs, sampled at its own rate.
+    void connect(const std::string& from, const std::string& to) {
+        require_stopped();
+        Task& source = find(from);
+        Task& sink = find(to);
+        if (&source == &sink) {
+            throw std::invalid_argument("A process cannot feed itself");
+        }
+        sink.input = &source;
+    }
+
+    // Start running every process on the given number of worker threads.
+    // Zero means one per hardware thread.
+    void start(unsigned threads = 0) {
+        require_stopped();
+        if (threads == 0) {
+            threads = std::max(1u, std::thread::hardware_concurrency());
+        }
+        clock::time_point now = clock::now();
+        queue = std::priority_queue<Release>();
+        for (auto& task : tasks) {
+            task->failed.store(false, std::memory_order_relaxed);
+            task->error = nullptr;
+            task->deadline = now;
+            queue.push(Release{now, task.get()});
+        }
+        running = true;
+        for (unsigned i = 0; i < threads; i++) {
+            workers.push_back(std::thread(&ProcessManager::work, this, i));
+        }
+    }
+
+    // Stop after the updates in progress finish
+    void stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running) {
+                return;
+            }
+            running = false;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) {
+            worker.join();
+        }
+        workers.clear();
+    }
+
+    // Run for the given time, then stop
+    void run_for(std::chrono::nanoseconds duration, unsigned threads = 0) {
+        start(threads);
+        std::this_thread::sleep_for(duration);
+        stop();
+    }
+
+    bool is_running() const {
+        return running;
+    }
+
+    std::size_t size() const {
+        return tasks.size();
+    }
+
+    // Latest output of a process
+    double output(const std::string& name) const {
+        return find(name).output.load(std::memory_order_acquire);
+    }
+
+    ProcessStats stats(const std::string& name) const {
+        const Task& task = find(name);
+        std::uint64_t updates = task.updates.load(std::memory_order_relaxed);
+        std::int64_t total = task.total_latency.load(std::memory_order_relaxed);
+        return ProcessStats{
+            task.name,
+            task.period,
+            updates,
+            task.overruns.load(std::memory_order_relaxed),
+            std::chrono::nanoseconds(task.last_latency.load(std::memory_order_relaxed)),
+            std::chrono::nanoseconds(updates == 0 ? 0 : total / (std::int64_t) updates),
+            task.failed.load(std::memory_order_relaxed)
+        };
+    }
+
+    // The exception a process's update threw, or null if none has
+    std::exception_ptr error(const std::string& name) const {
+        const Task& task = find(name);
+        std::lock_guard<std::mutex> lock(mutex);
+        return task.error;
+    }
+
+    // Stats of every process, in the order they were added
+    std::vector<ProcessStats> stats() const {
+        std::vector<ProcessStats> all;
+        for (auto& task : tasks) {
+            all.push_back(stats(task->name));
+        }
+        return all;
+    }
+};
+
+#endif // PROCESS_MANAGER_H
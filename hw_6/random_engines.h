@@ -0,0 +1,249 @@
+#ifndef RANDOM_ENGINES_H
+#define RANDOM_ENGINES_H
+
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <type_traits>
+
+// Small, fast random number engines with the interface of the standard ones
+// (result_type, min(), max() and operator()), so they can be used anywhere
+// std::mt19937 can, including in the standard distributions.
+
+// SplitMix64. Weak on its own, but every seed, including 0, gives a well
+// mixed sequence, so it is used to expand one 64 bit seed into the state of
+// the other engines.
+class SplitMix64 {
+public:
+    typedef std::uint64_t result_type;
+
+    explicit SplitMix64(std::uint64_t seed = 0) : state(seed) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        std::uint64_t z = (state += 0x9e3779b97f4a7c15);
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+        return z ^ (z >> 31);
+    }
+
+private:
+    std::uint64_t state;
+};
+
+// xoshiro256+ by Blackman and Vigna: 32 bytes of state and a handful of
+// instructions per value. The lowest bits are weak, which does not matter
+// when only the top 53 become a double.
+class Xoshiro256Plus {
+public:
+    typedef std::uint64_t result_type;
+
+    explicit Xoshiro256Plus(std::uint64_t seed = 0) {
+        SplitMix64 expand(seed);
+        for (std::uint64_t& word : s) {
+            word = expand();
+        }
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        std::uint64_t result = s[0] + s[3],
+                      t = s[1] << 17;
+        s[2] ^= s[0];
+        s[3] ^= s[1];
+        s[1] ^= s[2];
+        s[0] ^= s[3];
+        s[2] ^= t;
+        s[3] = (s[3] << 45) | (s[3] >> 19);
+        return result;
+    }
+
+private:
+    std::uint64_t s[4];
+};
+
+// PCG64 (XSL RR 128/64) by O'Neill: a 128 bit linear congruential generator
+// with a permuted output. stream selects one of 2^127 independent sequences.
+class Pcg64 {
+public:
+    typedef std::uint64_t result_type;
+
+    explicit Pcg64(std::uint64_t seed = 0, std::uint64_t stream = 0) :
+        state(0), increment(((unsigned __int128) stream << 1) | 1) {
+        step();
+        state += seed;
+        step();
+    }
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        step();
+        std::uint64_t folded = (std::uint64_t) (state >> 64) ^ (std::uint64_t) state;
+        unsigned rotation = (unsigned) (state >> 122);
+        return (folded >> rotation) | (folded << ((64 - rotation) & 63));
+    }
+
+private:
+    unsigned __int128 state, increment;
+
+    void step() {
+        const unsigned __int128 multiplier =
+            ((unsigned __int128) 2549297995355413942ULL << 64) | 6364136223846793005ULL;
+        state = state * multiplier + increment;
+    }
+};
+
+// Philox4x32-10 by Salmon et al. A counter based generator: output block i
+// is a keyed bijection of i, so any position in the sequence can be reached
+// in constant time and different keys or counters give independent streams
+// with no state to share. The key is the seed and the upper half of the
+// 128 bit counter is the stream id, so (seed, stream) pairs never overlap.
+class Philox4x32 {
+public:
+    typedef std::uint64_t result_type;
+
+    explicit Philox4x32(std::uint64_t seed = 0, std::uint64_t stream = 0) :
+        key{(std::uint32_t) seed, (std::uint32_t) (seed >> 32)},
+        stream{(std::uint32_t) stream, (std::uint32_t) (stream >> 32)},
+        index(0),
+        used(OUTPUTS) {}
+
+    static constexpr result_type min() { return 0; }
+    static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+    result_type operator()() {
+        if (used == OUTPUTS) {
+            refill();
+        }
+        return buffer[used++];
+    }
+
+    // Skip z outputs in constant time
+    void discard(unsigned long long z) {
+        unsigned long long position = OUTPUTS * index - (OUTPUTS - used) + z;
+        index = position / OUTPUTS;
+        used = OUTPUTS;
+        if (position % OUTPUTS) {
+            refill();
+            used = position % OUTPUTS;
+        }
+    }
+
+    // The ten round bijection, applied in place to a 128 bit counter
+    static void block(std::uint32_t counter[4], const std::uint32_t key[2]) {
+        std::uint32_t x0 = counter[0], x1 = counter[1], x2 = counter[2], x3 = counter[3],
+                      k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; round++) {
+            std::uint64_t p0 = (std::uint64_t) 0xD2511F53 * x0,
+                          p1 = (std::uint64_t) 0xCD9E8D57 * x2;
+            x0 = (std::uint32_t) (p1 >> 32) ^ x1 ^ k0;
+            x1 = (std::uint32_t) p1;
+            x2 = (std::uint32_t) (p0 >> 32) ^ x3 ^ k1;
+            x3 = (std::uint32_t) p0;
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        counter[0] = x0;
+        counter[1] = x1;
+        counter[2] = x2;
+        counter[3] = x3;
+    }
+
+private:
+    // Blocks are computed LANES at a time. One block is a chain of ten
+    // dependent multiplies; interleaving a second hides their latency
+    // (more lanes spill out of registers)
+    static constexpr unsigned LANES = 2, OUTPUTS = 2 * LANES;
+
+    std::uint32_t key[2], stream[2];
+    std::uint64_t index;            // Next group of LANES blocks to compute
+    std::uint64_t buffer[OUTPUTS];  // Outputs of the last group
+    unsigned used;                  // How many of them have been returned
+
+    void refill() {
+        std::uint32_t x0[LANES], x1[LANES], x2[LANES], x3[LANES];
+        for (unsigned lane = 0; lane < LANES; lane++) {
+            std::uint64_t block_index = index * LANES + lane;
+            x0[lane] = (std::uint32_t) block_index;
+            x1[lane] = (std::uint32_t) (block_index >> 32);
+            x2[lane] = stream[0];
+            x3[lane] = stream[1];
+        }
+        std::uint32_t k0 = key[0], k1 = key[1];
+        for (int round = 0; round < 10; round++) {
+            for (unsigned lane = 0; lane < LANES; lane++) {
+                std::uint64_t p0 = (std::uint64_t) 0xD2511F53 * x0[lane],
+                              p1 = (std::uint64_t) 0xCD9E8D57 * x2[lane];
+                x0[lane] = (std::uint32_t) (p1 >> 32) ^ x1[lane] ^ k0;
+                x1[lane] = (std::uint32_t) p1;
+                x2[lane] = (std::uint32_t) (p0 >> 32) ^ x3[lane] ^ k1;
+                x3[lane] = (std::uint32_t) p0;
+            }
+            k0 += 0x9E3779B9;
+            k1 += 0xBB67AE85;
+        }
+        for (unsigned lane = 0; lane < LANES; lane++) {
+            buffer[2 * lane] = ((std::uint64_t) x1[lane] << 32) | x0[lane];
+            buffer[2 * lane + 1] = ((std::uint64_t) x3[lane] << 32) | x2[lane];
+        }
+        index++;
+        used = 0;
+    }
+};
+
+// An engine for the given stream of a master seed. Pcg64 and Philox4x32
+// have stream ids built in. Other engines are seeded from a hash of the
+// pair, through std::seed_seq when they accept one; with 2^64 possible
+// states, overlaps between thousands of streams are vanishingly unlikely.
+template <typename Engine>
+Engine make_stream_engine(std::uint64_t seed, std::uint64_t stream) {
+    SplitMix64 mix(seed ^ SplitMix64(stream)());
+    std::uint64_t a = mix(), b = mix();
+    if constexpr (std::is_constructible<Engine, std::seed_seq&>::value) {
+        std::seed_seq sequence{(std::uint32_t) a, (std::uint32_t) (a >> 32),
+                               (std::uint32_t) b, (std::uint32_t) (b >> 32)};
+        return Engine(sequence);
+    } else {
+        return Engine((typename Engine::result_type) a);
+    }
+}
+
+template <>
+inline Pcg64 make_stream_engine<Pcg64>(std::uint64_t seed, std::uint64_t stream) {
+    return Pcg64(seed, stream);
+}
+
+template <>
+inline Philox4x32 make_stream_engine<Philox4x32>(std::uint64_t seed, std::uint64_t stream) {
+    return Philox4x32(seed, stream);
+}
+
+// Uniform double in [0, 1) from the top 53 bits of a 64 bit value: every
+// representable multiple of 2^-53 is equally likely
+constexpr double to_unit_double(std::uint64_t bits) {
+    return (double) (bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// Uniform double in [0, 1) from any engine. Engines producing full 64 or 32
+// bit words use one or two outputs and a multiply; others fall back to the
+// standard library.
+template <typename Engine>
+double random_unit_double(Engine& engine) {
+    constexpr std::uint64_t range = (std::uint64_t) (Engine::max() - Engine::min());
+    if (Engine::min() == 0 && range == 0xffffffffffffffff) {
+        return to_unit_double((std::uint64_t) engine());
+    } else if (Engine::min() == 0 && range == 0xffffffff) {
+        std::uint64_t high = (std::uint64_t) engine();
+        return to_unit_double((high << 32) | (std::uint64_t) engine());
+    } else {
+        return std::generate_canonical<double, std::numeric_limits<double>::digits>(engine);
+    }
+}
+
+#endif // RANDOM_ENGINES_H
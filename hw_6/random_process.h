@@ -3,30 +3,133 @@
 
 #include <random>
 #include <chrono>
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string>
 #include <vector>
+#include "random_engines.h"
+#include "ring_view.h"
 
-class RandomProcess {
+// How many generated values a RandomProcess keeps
+enum class HistoryPolicy {
+    None,       // only the latest value
+    Ring,       // the last `capacity` values, in a fixed buffer
+    Unbounded   // every value (memory grows with the number of updates)
+};
+
+// A process producing uniform random values in [0, 1). Engine is any random
+// number engine with the standard interface: std::mt19937 by default, or
+// one of the much smaller and faster engines in random_engines.h.
+//
+// Processes built from a master seed and a stream id are reproducible: the
+// same pair always gives the same values, and different stream ids give
+// independent ones, whichever thread the process runs on. Without a seed
+// the engine is seeded from std::random_device.
+template <typename Engine>
+class BasicRandomProcess {
 private:
     std::string name;
-    std::random_device rd;     // Will be used to obtain a seed for the random number engine
-    std::mt19937 gen;          // Standard mersenne_twister_engine seeded with rd()
-    std::uniform_real_distribution<> dis;  // Uniform distribution between 0 and 1
-    std::vector<double> output_values;     // Store generated values
+    Engine gen;                // Random number engine
+
+    HistoryPolicy policy;
+    std::vector<double> output_values;     // Stored values; a circular buffer for Ring
+    std::size_t next;                      // Ring slot the next value will be written to
+    std::size_t count;                     // Number of values currently stored
+    double last_value;                     // Latest value, kept under every policy
 
 public:
-    // Constructor
-    RandomProcess(std::string process_name) : 
+    // Constructor. capacity is the number of values kept by HistoryPolicy::Ring
+    // and is ignored by the other policies.
+    BasicRandomProcess(std::string process_name, HistoryPolicy policy = HistoryPolicy::Unbounded,
+                       std::size_t capacity = 0) :
+        BasicRandomProcess(process_name, random_seed(), 0, policy, capacity) {}
+
+    // Constructor for stream `stream` of the master seed `seed`
+    BasicRandomProcess(std::string process_name, std::uint64_t seed, std::uint64_t stream,
+                       HistoryPolicy policy = HistoryPolicy::Unbounded, std::size_t capacity = 0) :
         name(process_name),
-        gen(rd()), 
-        dis(0.0, 1.0) {}
+        gen(make_stream_engine<Engine>(seed, stream)),
+        policy(policy),
+        next(0),
+        count(0),
+        last_value(0.0) {
+        if (policy == HistoryPolicy::Ring) {
+            if (capacity == 0) {
+                throw std::invalid_argument("Ring history needs a positive capacity");
+            }
+            output_values.resize(capacity);
+        }
+    }
 
     // Generate a new random value and store it
     void update() {
         // Generate a random double between 0 and 1
-        double random_value = dis(gen);
-        
+        double random_value = random_unit_double(gen);
+        last_value = random_value;
+
         // Store the random value
-        output_values.push_back(random_value);
+        switch (policy) {
+            case HistoryPolicy::None:
+                count = 1;
+                break;
+            case HistoryPolicy::Ring:
+                output_values[next] = random_value;
+                if (++next == output_values.size()) {
+                    next = 0;
+                }
+                if (count < output_values.size()) {
+                    count++;
+                }
+                break;
+            case HistoryPolicy::Unbounded:
+                output_values.push_back(random_value);
+                count++;
+                break;
+        }
+    }
+
+    // Generate n values into out, as if update() had been called n times.
+    // The engine is copied into a local for the loop so its state can stay
+    // in registers, and the history is written once at the end.
+    void generate(std::size_t n, double* out) {
+        if (n == 0) {
+            return;
+        }
+        Engine local = gen;
+        for (std::size_t i = 0; i < n; i++) {
+            out[i] = random_unit_double(local);
+        }
+        gen = local;
+        last_value = out[n - 1];
+
+        switch (policy) {
+            case HistoryPolicy::None:
+                count = 1;
+                break;
+            case HistoryPolicy::Ring: {
+                std::size_t capacity = output_values.size(),
+                            kept = std::min(n, capacity);
+                for (std::size_t i = n - kept; i < n; i++) {
+                    output_values[next] = out[i];
+                    if (++next == capacity) {
+                        next = 0;
+                    }
+                }
+                count = std::min(capacity, count + kept);
+                break;
+            }
+            case HistoryPolicy::Unbounded:
+                output_values.insert(output_values.end(), out, out + n);
+                count += n;
+                break;
+        }
+    }
+
+    void generate(std::size_t n, std::vector<double>& out) {
+        out.resize(n);
+        generate(n, out.data());
     }
 
     // Get the name of the process
@@ -34,23 +137,53 @@ public:
         return name;
     }
 
+    HistoryPolicy get_policy() const {
+        return policy;
+    }
+
     // Get the latest generated value
     double latest() const {
-        if (output_values.empty()) {
-            return 0.0;
+        return count == 0 ? 0.0 : last_value;
+    }
+
+    // Get the stored values, oldest first. With HistoryPolicy::None this is
+    // just the latest value. The view is invalidated by the next update.
+    RingView<double> values() const {
+        switch (policy) {
+            case HistoryPolicy::None:
+                return RingView<double>(&last_value, 1, 0, count);
+            case HistoryPolicy::Ring:
+                return RingView<double>(output_values.data(), output_values.size(),
+                                        count == output_values.size() ? next : 0, count);
+            default:
+                return RingView<double>(output_values.data(), output_values.size(), 0, count);
         }
-        return output_values.back();
     }
 
-    // Get all generated values
-    const std::vector<double>& values() const {
-        return output_values;
+    // Bytes allocated for the history
+    std::size_t memory_footprint() const {
+        return output_values.capacity() * sizeof(double);
+    }
+
+    // A fresh seed from the operating system
+    static std::uint64_t random_seed() {
+        std::random_device rd;
+        return ((std::uint64_t) rd() << 32) | rd();
     }
 
     // Clear all stored values
     void clear() {
-        output_values.clear();
+        if (policy == HistoryPolicy::Unbounded) {
+            output_values.clear();
+        }
+        next = 0;
+        count = 0;
     }
 };
 
-#endif // RANDOM_PROCESS_H
\ No newline at end of file
+typedef BasicRandomProcess<std::mt19937> RandomProcess;
+typedef BasicRandomProcess<Xoshiro256Plus> XoshiroRandomProcess;
+typedef BasicRandomProcess<Pcg64> PcgRandomProcess;
+typedef BasicRandomProcess<Philox4x32> PhiloxRandomProcess;
+
+#endif // RANDOM_PROCESS_H
@@ -0,0 +1,69 @@
+#ifndef RING_VIEW_H
+#define RING_VIEW_H
+
+#include <cstddef>
+#include <iterator>
+#include <stdexcept>
+
+// A read-only view of the live part of a circular buffer, oldest element
+// first. It does not own the storage, so it is only valid until the buffer
+// it was taken from is next modified.
+template <typename T>
+class RingView {
+public:
+    class iterator {
+    public:
+        typedef std::forward_iterator_tag iterator_category;
+        typedef T value_type;
+        typedef std::ptrdiff_t difference_type;
+        typedef const T* pointer;
+        typedef const T& reference;
+
+        iterator(const RingView* view, std::size_t index) : view(view), index(index) {}
+
+        const T& operator*() const { return (*view)[index]; }
+        iterator& operator++() { index++; return *this; }
+        iterator operator++(int) { iterator old = *this; index++; return old; }
+        bool operator==(const iterator& other) const { return index == other.index; }
+        bool operator!=(const iterator& other) const { return index != other.index; }
+
+    private:
+        const RingView* view;
+        std::size_t index;
+    };
+
+    // buffer holds capacity slots; the oldest of the count live elements
+    // is at buffer[first]
+    RingView(const T* buffer, std::size_t capacity, std::size_t first, std::size_t count) :
+        buffer(buffer), capacity(capacity), first(first), count(count) {}
+
+    std::size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+
+    // Element i counting from the oldest
+    const T& operator[](std::size_t i) const {
+        std::size_t offset = first + i;
+        return buffer[offset < capacity ? offset : offset - capacity];
+    }
+
+    const T& at(std::size_t i) const {
+        if (i >= count) {
+            throw std::out_of_range("Index out of range in ring view");
+        }
+        return (*this)[i];
+    }
+
+    const T& front() const { return (*this)[0]; }
+    const T& back() const { return (*this)[count - 1]; }
+
+    iterator begin() const { return iterator(this, 0); }
+    iterator end() const { return iterator(this, count); }
+
+private:
+    const T* buffer;
+    std::size_t capacity,
+                first,
+                count;
+};
+
+#endif // RING_VIEW_H
@@ -2,22 +2,116 @@
 #define STOPWATCH_H
 
 #include <chrono>
+#include <cstdint>
+#include "latency_histogram.h"
+#if defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+// Clock policies for BasicStopwatch. A policy reads a raw tick count with
+// now() and converts a tick difference to nanoseconds with to_nanoseconds().
+
+// std::chrono::steady_clock, which is monotonic. Ticks are nanoseconds.
+struct SteadyClock {
+    typedef std::int64_t ticks;
+
+    static ticks now() {
+        return std::chrono::duration_cast<std::chrono::nanoseconds>(
+            std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    static std::int64_t to_nanoseconds(ticks t) {
+        return t;
+    }
+};
+
+// The processor's time stamp counter. Reading it takes a few nanoseconds,
+// against tens for steady_clock, which matters when the timed code is
+// itself sub-microsecond. The tick rate is measured against steady_clock
+// the first time ticks are converted, taking about 20 ms; call calibrate()
+// up front to keep that out of a measurement. Assumes an invariant TSC,
+// which all current x86 processors have. On other architectures this is
+// the same as SteadyClock.
+struct TscClock {
+    typedef std::int64_t ticks;
+
+    static ticks now() {
+#if defined(__x86_64__) || defined(__i386__)
+        _mm_lfence();   // do not let the read move ahead of earlier work
+        return (ticks) __rdtsc();
+#else
+        return SteadyClock::now();
+#endif
+    }
+
+    // Nanoseconds are ticks times scale / 2^32, in integer arithmetic
+    static std::int64_t to_nanoseconds(ticks t) {
+        return (std::int64_t) (((__int128) t * calibrate()) >> 32);
+    }
+
+    // Measure the tick rate, once; later calls return the stored result
+    static std::uint64_t calibrate() {
+        static const std::uint64_t scale = measure_scale();
+        return scale;
+    }
+
+private:
+    static std::uint64_t measure_scale() {
+#if defined(__x86_64__) || defined(__i386__)
+        ticks t0 = now();
+        std::int64_t n0 = SteadyClock::now(), n1;
+        do {
+            n1 = SteadyClock::now();
+        } while (n1 - n0 < 20000000);
+        ticks t1 = now();
+        return (std::uint64_t) (((unsigned __int128) (n1 - n0) << 32) / (std::uint64_t) (t1 - t0));
+#else
+        return (std::uint64_t) 1 << 32;
+#endif
+    }
+};
+
+// Accumulates elapsed time across start/stop pairs. Time is kept in clock
+// ticks and only converted when read, so start() and stop() are one clock
+// read each.
+//
+// In lap mode every start/stop interval, and every lap(), is also recorded
+// in a LatencyHistogram, for percentiles rather than just the total. The
+// histogram is not owned, so one can collect the laps of several
+// stopwatches on the same thread.
+template <typename ClockPolicy>
+class BasicStopwatch {
+public:
+    typedef typename ClockPolicy::ticks ticks;
 
-class Stopwatch {
 private:
-    std::chrono::time_point<std::chrono::high_resolution_clock> start_time;
-    std::chrono::time_point<std::chrono::high_resolution_clock> stop_time;
+    ticks start_time;
+    ticks elapsed;
     bool running;
-    std::chrono::nanoseconds elapsed;
+    LatencyHistogram* laps;   // Where intervals are recorded, or null
+
+    void end_interval(ticks now) {
+        ticks interval = now - start_time;
+        elapsed += interval;
+        if (laps) {
+            std::int64_t nanoseconds = ClockPolicy::to_nanoseconds(interval);
+            laps->record(nanoseconds > 0 ? (std::uint64_t) nanoseconds : 0);
+        }
+    }
 
 public:
     // Constructor initializes the stopwatch to 0 seconds
-    Stopwatch() : running(false), elapsed(std::chrono::nanoseconds::zero()) {}
+    BasicStopwatch() : start_time(0), elapsed(0), running(false), laps(nullptr) {}
+
+    // Record each interval in histogram from now on; null turns lap mode off
+    void record_laps(LatencyHistogram* histogram) {
+        laps = histogram;
+    }
 
     // Start the timer
     void start() {
         if (!running) {
-            start_time = std::chrono::high_resolution_clock::now();
+            start_time = ClockPolicy::now();
             running = true;
         }
     }
@@ -25,43 +119,60 @@ public:
     // Stop the timer
     void stop() {
         if (running) {
-            stop_time = std::chrono::high_resolution_clock::now();
-            elapsed += std::chrono::duration_cast<std::chrono::nanoseconds>(stop_time - start_time);
+            end_interval(ClockPolicy::now());
             running = false;
         }
     }
 
+    // End the current interval and start the next one with a single clock
+    // read. Starts the timer if it is stopped.
+    void lap() {
+        ticks now = ClockPolicy::now();
+        if (running) {
+            end_interval(now);
+        }
+        start_time = now;
+        running = true;
+    }
+
     // Reset the timer to zero
     void reset() {
-        elapsed = std::chrono::nanoseconds::zero();
+        elapsed = 0;
         running = false;
     }
 
+    // Get the total elapsed time in raw clock ticks
+    ticks get_ticks() const {
+        return running ? elapsed + (ClockPolicy::now() - start_time) : elapsed;
+    }
+
+    // Get the total elapsed time as an integer duration
+    std::chrono::nanoseconds get_duration() const {
+        return std::chrono::nanoseconds(ClockPolicy::to_nanoseconds(get_ticks()));
+    }
+
     // Get the total elapsed time in minutes
-    double get_minutes() {
+    double get_minutes() const {
         return get_nanoseconds() / (60.0 * 1e9);
     }
 
     // Get the total elapsed time in seconds
-    double get_seconds() {
+    double get_seconds() const {
         return get_nanoseconds() / 1e9;
     }
 
     // Get the total elapsed time in milliseconds
-    double get_milliseconds() {
+    double get_milliseconds() const {
         return get_nanoseconds() / 1e6;
     }
 
     // Get the total elapsed time in nanoseconds
-    double get_nanoseconds() {
-        if (running) {
-            auto current_time = std::chrono::high_resolution_clock::now();
-            auto current_elapsed = elapsed + std::chrono::duration_cast<std::chrono::nanoseconds>(current_time - start_time);
-            return static_cast<double>(current_elapsed.count());
-        } else {
-            return static_cast<double>(elapsed.count());
-        }
+    double get_nanoseconds() const {
+        return static_cast<double>(get_duration().count());
     }
 };
 
-#endif // STOPWATCH_H
\ No newline at end of file
+typedef BasicStopwatch<SteadyClock> Stopwatch;
+typedef BasicStopwatch<TscClock> TscStopwatch;
+
+#endif // STOPWATCH_H
@@ -0,0 +1,294 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <set>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "stopwatch.h"
+
+// Timeline tracing in the Chrome trace-event format, for seeing where time
+// goes across threads. Tracing is off until enabled:
+//
+//     TraceRecorder::instance().enable("run.json");   // written at exit
+//     ...
+//     void step() {
+//         TRACE_SCOPE("step");
+//         ...
+//     }
+//
+// Each traced scope records its name and its begin and end times, read from
+// SteadyClock, as one event in a buffer owned by the calling thread, so
+// recording takes no locks. Buffers have a fixed capacity; once a thread's
+// buffer is full, further events on that thread are counted and dropped.
+// The JSON can be written at any time with write_json(), or at exit, and
+// loads in chrome://tracing or https://ui.perfetto.dev.
+//
+// ScopedTimer scopes and ProcessManager updates are traced as well while
+// tracing is on. Defining NO_TRACING before including this header turns
+// TRACE_SCOPE into nothing.
+
+// One timed scope. Times are SteadyClock nanoseconds.
+struct TraceEvent {
+    const char* name;
+    std::int64_t begin, end;
+};
+
+// The events of one thread. Only the owning thread appends; the size is
+// published with a release store so readers see complete events.
+struct TraceBuffer {
+    unsigned tid;
+    std::string thread_name;               // Guarded by the recorder's mutex
+    std::unique_ptr<TraceEvent[]> events;  // Allocated on the first event
+    std::size_t capacity;
+    std::atomic<std::size_t> size{0};
+    std::atomic<std::uint64_t> dropped{0};
+
+    TraceBuffer(unsigned tid, std::size_t capacity) : tid(tid), capacity(capacity) {}
+
+    void append(const char* name, std::int64_t begin, std::int64_t end) {
+        std::size_t n = size.load(std::memory_order_relaxed);
+        if (n == capacity) {
+            dropped.store(dropped.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            return;
+        }
+        if (!events) {
+            events.reset(new TraceEvent[capacity]);
+        }
+        events[n] = TraceEvent{name, begin, end};
+        size.store(n + 1, std::memory_order_release);
+    }
+};
+
+class TraceRecorder {
+public:
+    static constexpr std::size_t DEFAULT_CAPACITY = 1 << 16;   // Events per thread
+
+    static TraceRecorder& instance() {
+        static TraceRecorder recorder;
+        return recorder;
+    }
+
+    // Whether events are being recorded; one relaxed load
+    static bool enabled() {
+        return instance().on.load(std::memory_order_relaxed);
+    }
+
+    // Start recording. If path is not empty the trace is written there when
+    // the program exits. Buffers created from now on hold capacity events.
+    void enable(const std::string& path = "", std::size_t capacity = DEFAULT_CAPACITY) {
+        if (capacity == 0) {
+            throw std::invalid_argument("Trace buffers need a capacity of at least one event");
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        exit_path = path;
+        buffer_capacity = capacity;
+        on.store(true, std::memory_order_relaxed);
+    }
+
+    // Stop recording; recorded events are kept
+    void disable() {
+        on.store(false, std::memory_order_relaxed);
+    }
+
+    // Append an event to the calling thread's buffer if tracing is on
+    void record(const char* name, std::int64_t begin, std::int64_t end) {
+        if (enabled()) {
+            local().append(name, begin, end);
+        }
+    }
+
+    // Label the calling thread in the trace viewer. A thread that has not
+    // recorded anything yet keeps the name until its first event, so naming
+    // threads costs nothing while tracing is off.
+    void set_thread_name(const std::string& name) {
+        TraceBuffer* buffer = local_buffer();
+        if (!buffer) {
+            pending_thread_name() = name;
+            return;
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        buffer->thread_name = name;
+    }
+
+    // A copy of name that lives as long as the recorder, for names that
+    // are not string literals
+    const char* intern(const std::string& name) {
+        std::lock_guard<std::mutex> lock(mutex);
+        return names.insert(name).first->c_str();
+    }
+
+    std::size_t event_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::size_t n = 0;
+        for (auto& buffer : buffers) {
+            n += buffer->size.load(std::memory_order_acquire);
+        }
+        return n;
+    }
+
+    std::uint64_t dropped_count() {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::uint64_t n = 0;
+        for (auto& buffer : buffers) {
+            n += buffer->dropped.load(std::memory_order_relaxed);
+        }
+        return n;
+    }
+
+    // Every event recorded so far as Chrome trace-event JSON. Safe while
+    // other threads are still recording; their later events are left out.
+    void write_json(std::ostream& out) {
+        std::lock_guard<std::mutex> lock(mutex);
+        char line[128];
+        std::uint64_t dropped = 0;
+        bool first = true;
+        out << "{\"traceEvents\": [";
+        for (auto& buffer : buffers) {
+            std::size_t n = buffer->size.load(std::memory_order_acquire);
+            dropped += buffer->dropped.load(std::memory_order_relaxed);
+            if (!buffer->thread_name.empty()) {
+                out << (first ? "\n" : ",\n") << "  {\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": "
+                    << buffer->tid << ", \"args\": {\"name\": \"";
+                write_escaped(out, buffer->thread_name.c_str());
+                out << "\"}}";
+                first = false;
+            }
+            for (std::size_t i = 0; i < n; i++) {
+                const TraceEvent& e = buffer->events[i];
+                out << (first ? "\n" : ",\n") << "  {\"name\": \"";
+                write_escaped(out, e.name);
+                // Complete events: begin time and duration, in microseconds
+                snprintf(line, sizeof line, "\", \"ph\": \"X\", \"pid\": 1, \"tid\": %u, \"ts\": %.3f, \"dur\": %.3f}",
+                         buffer->tid, (e.begin - epoch) / 1e3, (e.end - e.begin) / 1e3);
+                out << line;
+                first = false;
+            }
+        }
+        out << (first ? "]" : "\n]") << ",\n \"displayTimeUnit\": \"ns\",\n \"otherData\": {\"dropped_events\": "
+            << dropped << "}}\n";
+    }
+
+    std::string json() {
+        std::ostringstream out;
+        write_json(out);
+        return out.str();
+    }
+
+    void write_file(const std::string& path) {
+        std::ofstream out(path);
+        if (!out) {
+            throw std::runtime_error("Cannot write trace to " + path);
+        }
+        write_json(out);
+    }
+
+    // Write s as the inside of a JSON string literal
+    static void write_escaped(std::ostream& out, const char* s) {
+        for (; *s; s++) {
+            if (*s == '"' || *s == '\\') {
+                out << '\\' << *s;
+            } else if ((unsigned char) *s < 0x20) {
+                char escape[8];
+                snprintf(escape, sizeof escape, "\\u%04x", (unsigned) *s);
+                out << escape;
+            } else {
+                out << *s;
+            }
+        }
+    }
+
+    // Discard every event. Must not run while other threads are recording.
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex);
+        for (auto& buffer : buffers) {
+            buffer->size.store(0, std::memory_order_relaxed);
+            buffer->dropped.store(0, std::memory_order_relaxed);
+        }
+    }
+
+private:
+    std::atomic<bool> on{false};
+    std::mutex mutex;
+    std::vector<std::unique_ptr<TraceBuffer>> buffers;   // Every thread's; outlive their threads
+    std::set<std::string> names;                         // Interned names
+    std::size_t buffer_capacity = DEFAULT_CAPACITY;
+    std::string exit_path;
+    std::int64_t epoch;                                  // Time zero in the trace
+
+    TraceRecorder() : epoch(SteadyClock::now()) {}
+
+    ~TraceRecorder() {
+        if (!exit_path.empty()) {
+            try {
+                write_file(exit_path);
+            } catch (const std::exception& e) {
+                fprintf(stderr, "%s\n", e.what());
+            }
+        }
+    }
+
+    static TraceBuffer*& local_buffer() {
+        thread_local TraceBuffer* buffer = nullptr;
+        return buffer;
+    }
+
+    // Name given to the calling thread before it had a buffer
+    static std::string& pending_thread_name() {
+        thread_local std::string name;
+        return name;
+    }
+
+    // The calling thread's buffer, created on first use
+    TraceBuffer& local() {
+        TraceBuffer*& buffer = local_buffer();
+        if (!buffer) {
+            std::lock_guard<std::mutex> lock(mutex);
+            buffers.emplace_back(new TraceBuffer((unsigned) buffers.size() + 1, buffer_capacity));
+            buffer = buffers.back().get();
+            buffer->thread_name.swap(pending_thread_name());
+        }
+        return *buffer;
+    }
+};
+
+// Traces its own lifetime under a name that must outlive the recorder,
+// such as a string literal or one from TraceRecorder::intern()
+class TraceScope {
+public:
+    explicit TraceScope(const char* name) :
+        name(TraceRecorder::enabled() ? name : nullptr), begin(this->name ? SteadyClock::now() : 0) {}
+
+    ~TraceScope() {
+        if (name) {
+            TraceRecorder::instance().record(name, begin, SteadyClock::now());
+        }
+    }
+
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+private:
+    const char* name;
+    std::int64_t begin;
+};
+
+#define TRACE_SCOPE_JOIN2(a, b) a##b
+#define TRACE_SCOPE_JOIN(a, b) TRACE_SCOPE_JOIN2(a, b)
+
+#ifdef NO_TRACING
+#define TRACE_SCOPE(name) ((void) 0)
+#else
+#define TRACE_SCOPE(name) TraceScope TRACE_SCOPE_JOIN(trace_scope_, __LINE__)(name)
+#endif
+
+#endif // TRACE_H
@@ -2,10 +2,24 @@
 #include "random_process.h"
 #include "filter.h"
 #include "integrator.h"
+#include "batch_integration.h"
+#include "process_manager.h"
+#include "channel.h"
+#include "scoped_timer.h"
+#include "concurrent_stopwatch.h"
+#include "benchmark.h"
+#include "trace.h"
+#include "ema_filter.h"
+#include "median_filter.h"
+#include "extremum_filter.h"
 #include "stopwatch.h"
 #include <thread>
 #include <chrono>
 #include <cmath>
+#include <algorithm>
+#include <vector>
+#include <atomic>
+#include <stdexcept>
 
 // Test the Stopwatch class
 class StopwatchTest : public ::testing::Test {
@@ -89,6 +103,106 @@ TEST_F(StopwatchTest, TimeUnits) {
     EXPECT_GT(watch.get_nanoseconds(), 0.0);
 }
 
+// Test the time stamp counter clock against a sleep
+TEST(ClockPolicyTest, TscStopwatch) {
+    TscClock::calibrate();
+    TscStopwatch tsc;
+    Stopwatch steady;
+    tsc.start();
+    steady.start();
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    tsc.stop();
+    steady.stop();
+    EXPECT_NEAR(tsc.get_seconds(), 0.1, 0.05);
+    EXPECT_NEAR(tsc.get_seconds(), steady.get_seconds(), 0.01);
+    EXPECT_GT(tsc.get_ticks(), 0);
+    EXPECT_EQ(tsc.get_duration().count(), (long long) tsc.get_nanoseconds());
+}
+
+// Test the integer accessors, including while running
+TEST(ClockPolicyTest, IntegerTicks) {
+    Stopwatch watch;
+    EXPECT_EQ(watch.get_ticks(), 0);
+    watch.start();
+    std::int64_t first = watch.get_ticks();
+    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    std::int64_t second = watch.get_ticks();
+    EXPECT_GE(first, 0);
+    EXPECT_GT(second, first);
+    watch.stop();
+    EXPECT_GE(watch.get_duration(), std::chrono::milliseconds(1));
+    EXPECT_EQ(watch.get_duration().count(), watch.get_ticks());   // steady ticks are nanoseconds
+}
+
+// Test that buckets tile the range and keep the relative error bounded
+TEST(LatencyHistogramTest, Buckets) {
+    EXPECT_EQ(LatencyHistogram::bucket_index(0), 0);
+    EXPECT_EQ(LatencyHistogram::bucket_index(63), 63);
+    EXPECT_EQ(LatencyHistogram::bucket_index(64), 64);
+    EXPECT_EQ(LatencyHistogram::bucket_index(~0ULL), LatencyHistogram::BUCKETS - 1);
+    for (std::size_t i = 0; i + 1 < LatencyHistogram::BUCKETS; i++) {
+        EXPECT_EQ(LatencyHistogram::bucket_high(i) + 1, LatencyHistogram::bucket_low(i + 1));
+    }
+    for (std::uint64_t v : {1ULL, 100ULL, 1000ULL, 123456789ULL, 1ULL << 40, (1ULL << 62) + 12345}) {
+        std::size_t i = LatencyHistogram::bucket_index(v);
+        EXPECT_LE(LatencyHistogram::bucket_low(i), v);
+        EXPECT_GE(LatencyHistogram::bucket_high(i), v);
+        EXPECT_LE(LatencyHistogram::bucket_high(i) - LatencyHistogram::bucket_low(i), v / 64);
+    }
+}
+
+// Test percentiles, merging and reset on known values
+TEST(LatencyHistogramTest, Percentiles) {
+    LatencyHistogram low, high;
+    for (std::uint64_t v = 1; v <= 50000; v++) {
+        low.record(v);
+        high.record(v + 50000);
+    }
+    EXPECT_EQ(low.max(), 50000);
+    low.merge(high);
+    EXPECT_EQ(low.count(), 100000);
+    EXPECT_EQ(low.min(), 1);
+    EXPECT_EQ(low.max(), 100000);
+    EXPECT_DOUBLE_EQ(low.mean(), 50000.5);
+    EXPECT_NEAR(low.p50(), 50000, 50000 / 64.0);
+    EXPECT_NEAR(low.p90(), 90000, 90000 / 64.0);
+    EXPECT_NEAR(low.p99(), 99000, 99000 / 64.0);
+    EXPECT_NEAR(low.p999(), 99900, 99900 / 64.0);
+    EXPECT_EQ(low.percentile(100.0), 100000);
+    EXPECT_THROW(low.percentile(101.0), std::invalid_argument);
+
+    low.reset();
+    EXPECT_EQ(low.count(), 0);
+    EXPECT_EQ(low.p99(), 0);
+    EXPECT_EQ(low.max(), 0);
+}
+
+// Test that lap mode records each interval
+TEST(LatencyHistogramTest, StopwatchLaps) {
+    LatencyHistogram laps;
+    Stopwatch watch;
+    watch.record_laps(&laps);
+    for (int i = 0; i < 3; i++) {
+        watch.start();
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+        watch.stop();
+    }
+    watch.lap();
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    watch.lap();
+    watch.stop();
+    EXPECT_EQ(laps.count(), 5);
+    EXPECT_GE(laps.p50(), 2000000);
+    EXPECT_GE(laps.max(), 20000000);
+    EXPECT_LE(laps.min(), 1000000);   // the lap straight before stop()
+    EXPECT_NEAR(watch.get_nanoseconds(), laps.mean() * 5, 0.02 * watch.get_nanoseconds());
+
+    watch.record_laps(nullptr);
+    watch.start();
+    watch.stop();
+    EXPECT_EQ(laps.count(), 5);
+}
+
 // Test fixture for RandomProcess
 class RandomProcessTest : public ::testing::Test {
 protected:
@@ -109,6 +223,194 @@ TEST_F(RandomProcessTest, ValuesInRange) {
     }
 }
 
+// Test that each history policy keeps what it promises
+TEST(RandomProcessHistoryTest, Policies) {
+    RandomProcess none("none", HistoryPolicy::None),
+                  ring("ring", HistoryPolicy::Ring, 4),
+                  unbounded("unbounded");
+    EXPECT_TRUE(none.values().empty());
+    EXPECT_DOUBLE_EQ(ring.latest(), 0.0);
+    EXPECT_EQ(unbounded.get_policy(), HistoryPolicy::Unbounded);
+
+    std::vector<double> ring_values;
+    for (int i = 0; i < 10; i++) {
+        none.update();
+        ring.update();
+        unbounded.update();
+        ring_values.push_back(ring.latest());
+    }
+    EXPECT_EQ(none.values().size(), 1);
+    EXPECT_DOUBLE_EQ(none.values().back(), none.latest());
+    EXPECT_EQ(unbounded.values().size(), 10);
+    EXPECT_DOUBLE_EQ(unbounded.values().back(), unbounded.latest());
+
+    // The ring holds the last four values, oldest first
+    ASSERT_EQ(ring.values().size(), 4);
+    EXPECT_TRUE(std::equal(ring.values().begin(), ring.values().end(), ring_values.end() - 4));
+
+    ring.clear();
+    EXPECT_TRUE(ring.values().empty());
+    EXPECT_DOUBLE_EQ(ring.latest(), 0.0);
+    EXPECT_THROW(RandomProcess("bad", HistoryPolicy::Ring, 0), std::invalid_argument);
+}
+
+// Test that bounded histories do not grow with the number of updates
+TEST(RandomProcessHistoryTest, MemoryFootprint) {
+    RandomProcess none("none", HistoryPolicy::None),
+                  ring("ring", HistoryPolicy::Ring, 1000);
+    EXPECT_EQ(ring.memory_footprint(), 1000 * sizeof(double));
+    for (int i = 0; i < 1000000; i++) {
+        none.update();
+        ring.update();
+    }
+    EXPECT_EQ(none.memory_footprint(), 0);
+    EXPECT_EQ(ring.memory_footprint(), 1000 * sizeof(double));
+    EXPECT_EQ(ring.values().size(), 1000);
+}
+
+// The same with a billion updates. Takes about a minute, so it only runs
+// with --gtest_also_run_disabled_tests.
+TEST(RandomProcessHistoryTest, DISABLED_MemoryFootprintBillion) {
+    RandomProcess ring("ring", HistoryPolicy::Ring, 1000);
+    for (long i = 0; i < 1000000000L; i++) {
+        ring.update();
+    }
+    EXPECT_EQ(ring.memory_footprint(), 1000 * sizeof(double));
+    EXPECT_GE(ring.latest(), 0.0);
+}
+
+// Test the engines against known values and each other
+TEST(RandomEngineTest, Engines) {
+    SplitMix64 splitmix(0);
+    EXPECT_EQ(splitmix(), 0xe220a8397b1dcdafULL);
+
+    Xoshiro256Plus a(7), b(7), c(8);
+    Pcg64 p(7), q(7), r(7, 1);
+    bool differs = false, stream_differs = false;
+    for (int i = 0; i < 100; i++) {
+        std::uint64_t x = a(), y = p();
+        EXPECT_EQ(x, b());
+        EXPECT_EQ(y, q());
+        differs = differs || x != c();
+        stream_differs = stream_differs || y != r();
+    }
+    EXPECT_TRUE(differs);
+    EXPECT_TRUE(stream_differs);
+
+    EXPECT_DOUBLE_EQ(to_unit_double(0), 0.0);
+    EXPECT_LT(to_unit_double(~0ULL), 1.0);
+    EXPECT_DOUBLE_EQ(to_unit_double(1ULL << 63), 0.5);
+}
+
+// Bulk generation into an array, for every engine
+template <typename Process>
+void check_generate() {
+    Process process("bulk", HistoryPolicy::Ring, 100);
+    std::vector<double> out;
+    process.generate(10000, out);
+    ASSERT_EQ(out.size(), 10000);
+    double sum = 0.0;
+    for (double x : out) {
+        EXPECT_GE(x, 0.0);
+        EXPECT_LT(x, 1.0);
+        sum += x;
+    }
+    EXPECT_NEAR(sum / out.size(), 0.5, 0.02);
+
+    // The history holds the last 100 generated values
+    EXPECT_DOUBLE_EQ(process.latest(), out.back());
+    ASSERT_EQ(process.values().size(), 100);
+    EXPECT_TRUE(std::equal(process.values().begin(), process.values().end(), out.end() - 100));
+    process.update();
+    EXPECT_EQ(process.values().size(), 100);
+    EXPECT_DOUBLE_EQ(process.values().back(), process.latest());
+}
+
+TEST(RandomEngineTest, Generate) {
+    check_generate<RandomProcess>();
+    check_generate<XoshiroRandomProcess>();
+    check_generate<PcgRandomProcess>();
+
+    RandomProcess unbounded("unbounded");
+    double out[5];
+    unbounded.update();
+    unbounded.generate(5, out);
+    EXPECT_EQ(unbounded.values().size(), 6);
+    EXPECT_DOUBLE_EQ(unbounded.values()[1], out[0]);
+}
+
+// Test Philox against the Random123 known answers and its skip ahead
+TEST(RandomStreamTest, Philox) {
+    std::uint32_t zeros[4] = {0, 0, 0, 0}, zero_key[2] = {0, 0};
+    Philox4x32::block(zeros, zero_key);
+    EXPECT_EQ(zeros[0], 0x6627e8d5u);
+    EXPECT_EQ(zeros[3], 0x9b00dbd8u);
+    std::uint32_t pi[4] = {0x243f6a88, 0x85a308d3, 0x13198a2e, 0x03707344},
+                  pi_key[2] = {0xa4093822, 0x299f31d0};
+    Philox4x32::block(pi, pi_key);
+    EXPECT_EQ(pi[0], 0xd16cfe09u);
+    EXPECT_EQ(pi[1], 0x94fdccebu);
+    EXPECT_EQ(pi[2], 0x5001e420u);
+    EXPECT_EQ(pi[3], 0x24126ea1u);
+
+    Philox4x32 stepped(3, 4), skipped(3, 4);
+    for (int i = 0; i < 1001; i++) {
+        stepped();
+    }
+    skipped.discard(1001);
+    EXPECT_EQ(stepped(), skipped());
+}
+
+// Values of stream ids [first, last), each process in turn, into results
+template <typename Process>
+void run_streams(std::uint64_t seed, std::size_t first, std::size_t last,
+                 std::vector<std::vector<double>>& results) {
+    for (std::size_t id = first; id < last; id++) {
+        Process process("stream", seed, id, HistoryPolicy::None);
+        results[id].resize(100);
+        process.generate(50, results[id].data());
+        for (int i = 50; i < 100; i++) {
+            process.update();
+            results[id][i] = process.latest();
+        }
+    }
+}
+
+// Values of 1000 streams computed on the given number of threads
+template <typename Process>
+std::vector<std::vector<double>> parallel_streams(std::uint64_t seed, unsigned threads) {
+    const std::size_t streams = 1000;
+    std::vector<std::vector<double>> results(streams);
+    std::vector<std::thread> workers;
+    for (unsigned t = 0; t < threads; t++) {
+        workers.push_back(std::thread(run_streams<Process>, seed, streams * t / threads,
+                                      streams * (t + 1) / threads, std::ref(results)));
+    }
+    for (auto& worker : workers) {
+        worker.join();
+    }
+    return results;
+}
+
+// Test that seeded runs do not depend on the number of threads
+template <typename Process>
+void check_streams() {
+    auto one = parallel_streams<Process>(42, 1);
+    EXPECT_EQ(one, parallel_streams<Process>(42, 3));
+    EXPECT_EQ(one, parallel_streams<Process>(42, 8));
+    EXPECT_NE(one, parallel_streams<Process>(43, 2));
+    // Streams of the same seed differ from each other
+    EXPECT_NE(one[0], one[1]);
+    EXPECT_NE(one[1], one[999]);
+}
+
+TEST(RandomStreamTest, ThreadCountIndependent) {
+    check_streams<PhiloxRandomProcess>();
+    check_streams<PcgRandomProcess>();
+    check_streams<XoshiroRandomProcess>();
+    check_streams<RandomProcess>();
+}
+
 // Test fixture for Filter
 class FilterTest : public ::testing::Test {
 protected:
@@ -161,6 +463,180 @@ TEST_F(FilterTest, AlternatingValues) {
     EXPECT_DOUBLE_EQ(filter.value(), 0.5);
 }
 
+// Test that get_values() lists the window oldest first
+TEST_F(FilterTest, ValuesOldestFirst) {
+    for (int i = 1; i <= 13; i++) {
+        filter.update(i);
+    }
+    auto values = filter.get_values();
+    ASSERT_EQ(values.size(), 10);
+    EXPECT_DOUBLE_EQ(values.front(), 4.0);
+    EXPECT_DOUBLE_EQ(values.back(), 13.0);
+    double expected = 4.0;
+    for (double v : values) {
+        EXPECT_DOUBLE_EQ(v, expected);
+        expected += 1.0;
+    }
+    EXPECT_THROW(values.at(10), std::out_of_range);
+}
+
+// Test that the incremental sum does not drift over a long run
+TEST_F(FilterTest, NoDriftOverLongRun) {
+    std::vector<double> last(10);
+    for (int i = 0; i < 1000000; i++) {
+        double x = (i % 3 == 0 ? 1e6 : 1e-3) * ((i * 7919) % 101) / 101.0;
+        filter.update(x);
+        last[i % 10] = x;
+    }
+    double exact = 0.0;
+    for (double x : last) {
+        exact += x;
+    }
+    EXPECT_NEAR(filter.value(), exact / 10, 1e-9 * std::abs(exact / 10));
+}
+
+// Test float, integer and run-time sized instantiations
+TEST(TypedFilterTest, OtherWindowsAndTypes) {
+    TypedFilter<float, 4> small("float");
+    TypedFilter<short, 3> fixed_point("short");
+    DynamicFilter dynamic("dynamic", 100);
+    for (int i = 1; i <= 200; i++) {
+        small.update(i);
+        fixed_point.update(i);
+        dynamic.update(i);
+    }
+    EXPECT_DOUBLE_EQ(small.value(), 198.5);        // 197..200
+    EXPECT_DOUBLE_EQ(fixed_point.value(), 199.0);  // 198..200
+    EXPECT_DOUBLE_EQ(dynamic.value(), 150.5);      // 101..200
+    EXPECT_EQ(dynamic.window(), 100);
+    EXPECT_EQ(dynamic.get_values().front(), 101.0);
+    EXPECT_EQ(small.window(), 4);
+    EXPECT_EQ(sizeof(TypedFilter<float, 64>) - sizeof(TypedFilter<float, 32>), 32 * sizeof(float));
+
+    TypedFilter<unsigned, 2> unsigned_filter("unsigned");
+    unsigned_filter.update(4000000000u);
+    unsigned_filter.update(2);
+    unsigned_filter.update(4);
+    EXPECT_DOUBLE_EQ(unsigned_filter.value(), 3.0);
+
+    EXPECT_THROW(DynamicFilter("empty", 0), std::invalid_argument);
+    EXPECT_THROW((TypedFilter<double, 5>("wrong", 6)), std::invalid_argument);
+}
+
+// Feeds the same data one value at a time and in blocks of several sizes
+template <typename F, typename T>
+void check_block_update(F& single, F& blocked, const std::vector<T>& data) {
+    const size_t blocks[] = {0, 1, 3, 10, 37, 2000, 9000};
+    size_t start = 0;
+    for (size_t b = 0; start < data.size(); b = (b + 1) % 7) {
+        size_t n = std::min(blocks[b], data.size() - start);
+        std::vector<T> block(data.begin() + start, data.begin() + start + n);
+        std::vector<double> averages;
+        blocked.update(block, averages);
+        ASSERT_EQ(averages.size(), n);
+        for (size_t i = 0; i < n; i++) {
+            single.update(block[i]);
+            ASSERT_NEAR(averages[i], single.value(), 1e-9) << "at sample " << start + i;
+        }
+        EXPECT_NEAR(blocked.value(), single.value(), 1e-12);
+        start += n;
+    }
+    auto a = single.get_values(), b = blocked.get_values();
+    ASSERT_EQ(a.size(), b.size());
+    for (size_t i = 0; i < a.size(); i++) {
+        EXPECT_EQ(a[i], b[i]);
+    }
+}
+
+// Test that block updates give the same averages as single updates
+TEST(TypedFilterTest, BlockUpdateMatchesSingle) {
+    std::vector<double> data;
+    std::vector<int> ints;
+    for (int i = 0; i < 30000; i++) {
+        data.push_back(sin(0.01 * i) * 100 + (i * 7919) % 13);
+        ints.push_back((i * 7919) % 1001 - 500);
+    }
+
+    Filter single("single"), blocked("blocked");
+    check_block_update(single, blocked, data);
+
+    DynamicFilter single_wide("single", 5000), blocked_wide("blocked", 5000);
+    check_block_update(single_wide, blocked_wide, data);
+
+    TypedFilter<int, 7> single_int("single"), blocked_int("blocked");
+    check_block_update(single_int, blocked_int, ints);
+}
+
+// Test a block update without per-sample output
+TEST_F(FilterTest, BlockUpdateWithoutOutput) {
+    std::vector<double> data;
+    for (int i = 1; i <= 1000; i++) {
+        data.push_back(i);
+    }
+    filter.update(data);
+    EXPECT_DOUBLE_EQ(filter.value(), 995.5);   // 991..1000
+    filter.update(data.data(), 3);
+    EXPECT_DOUBLE_EQ(filter.value(), 698.5);   // 994..1000, 1, 2, 3
+    EXPECT_DOUBLE_EQ(filter.get_values().back(), 3.0);
+}
+
+// Test the exponential moving average
+TEST(EmaFilterTest, Smoothing) {
+    EmaFilter ema("ema", 0.5);
+    EXPECT_EQ(ema.get_name(), "ema");
+    EXPECT_DOUBLE_EQ(ema.value(), 0.0);
+    ema.update(4.0);
+    EXPECT_DOUBLE_EQ(ema.value(), 4.0);
+    ema.update(0.0);
+    EXPECT_DOUBLE_EQ(ema.value(), 2.0);
+    ema.update(2.0);
+    EXPECT_DOUBLE_EQ(ema.value(), 2.0);
+    for (int i = 0; i < 100; i++) {
+        ema.update(10.0);
+    }
+    EXPECT_NEAR(ema.value(), 10.0, 1e-12);
+    EXPECT_THROW(EmaFilter("bad", 0.0), std::invalid_argument);
+    EXPECT_THROW(EmaFilter("bad", 1.5), std::invalid_argument);
+}
+
+// Test median, min and max against a brute force over the window
+TEST(WindowFilterTest, MatchesBruteForce) {
+    for (size_t window : {1, 2, 5, 64}) {
+        MedianFilter median("median", window);
+        MinFilter min_filter("min", window);
+        MaxFilter max_filter("max", window);
+        std::vector<double> history;
+        for (int i = 0; i < 2000; i++) {
+            // Few distinct values so that ties are common
+            double x = (double) ((i * 7919 + i / 3) % 17) - 8;
+            median.update(x);
+            min_filter.update(x);
+            max_filter.update(x);
+            history.push_back(x);
+
+            std::vector<double> w(history.end() - std::min(window, history.size()), history.end());
+            std::sort(w.begin(), w.end());
+            double expected_median = w.size() % 2 ? w[w.size() / 2]
+                                                  : (w[w.size() / 2 - 1] + w[w.size() / 2]) / 2;
+            ASSERT_DOUBLE_EQ(median.value(), expected_median) << "window " << window << " at " << i;
+            ASSERT_DOUBLE_EQ(min_filter.value(), w.front()) << "window " << window << " at " << i;
+            ASSERT_DOUBLE_EQ(max_filter.value(), w.back()) << "window " << window << " at " << i;
+        }
+    }
+}
+
+// Test the edge cases of the windowed filters
+TEST(WindowFilterTest, EmptyAndInvalid) {
+    MedianFilter median("median", 3);
+    MinFilter min_filter("min", 3);
+    EXPECT_DOUBLE_EQ(median.value(), 0.0);
+    EXPECT_DOUBLE_EQ(min_filter.value(), 0.0);
+    EXPECT_EQ(median.get_name(), "median");
+    EXPECT_EQ(min_filter.get_name(), "min");
+    EXPECT_THROW(MedianFilter("bad", 0), std::invalid_argument);
+    EXPECT_THROW(MaxFilter("bad", 0), std::invalid_argument);
+}
+
 // Test fixture for Integrator
 class IntegratorTest : public ::testing::Test {
 protected:
@@ -218,3 +694,766 @@ TEST_F(IntegratorTest, ChangingValues) {
     // The result will vary based on exact timing, but should be positive
     EXPECT_GT(integrator.value(), 0.0);
 }
+
+// A clock that only moves when told to, for deterministic integrator tests
+struct FakeClock {
+    typedef std::chrono::nanoseconds duration;
+    typedef duration::rep rep;
+    typedef duration::period period;
+    typedef std::chrono::time_point<FakeClock> time_point;
+    static const bool is_steady = true;
+
+    static time_point current;
+    static time_point now() { return current; }
+    static void advance(double seconds) {
+        current += std::chrono::duration_cast<duration>(std::chrono::duration<double>(seconds));
+    }
+};
+FakeClock::time_point FakeClock::current;
+
+FakeClock::time_point at_seconds(double t) {
+    return FakeClock::time_point(std::chrono::duration_cast<FakeClock::duration>(std::chrono::duration<double>(t)));
+}
+
+// Test that update(value) reads the injected clock
+TEST(BasicIntegratorTest, InjectedClock) {
+    BasicIntegrator<FakeClock> integrator("fake");
+    integrator.update(2.0);
+    FakeClock::advance(0.5);
+    integrator.update(2.0);
+    FakeClock::advance(0.25);
+    integrator.update(4.0);
+    EXPECT_NEAR(integrator.value(), 2.0, 1e-12);   // 2 * 0.5 + 4 * 0.25
+}
+
+// A clock that steps backwards adds a zero-width interval on the clock
+// path, but explicit decreasing timestamps are still rejected
+TEST(BasicIntegratorTest, ClockStepsBackwards) {
+    BasicIntegrator<FakeClock> integrator("fake");
+    integrator.update(2.0);
+    FakeClock::advance(0.5);
+    integrator.update(2.0);
+    FakeClock::advance(-10.0);
+    EXPECT_NO_THROW(integrator.update(2.0));
+    EXPECT_NEAR(integrator.value(), 1.0, 1e-12);
+    FakeClock::advance(0.25);
+    integrator.update(4.0);
+    EXPECT_NEAR(integrator.value(), 2.0, 1e-12);   // measured from the stepped-back time
+    EXPECT_THROW(integrator.update(1.0, FakeClock::now() - std::chrono::seconds(1)), std::invalid_argument);
+}
+
+// Test the three rules on a quadratic with uneven sample spacing
+TEST(BasicIntegratorTest, RulesOnQuadratic) {
+    // Integral of 3t^2 - 2t + 1 over [0, 2] is 6
+    auto f = [](double t) { return 3 * t * t - 2 * t + 1; };
+    double times[] = {0.0, 0.1, 0.35, 0.5, 0.8, 1.0, 1.1, 1.5, 1.6, 1.8, 2.0};
+
+    BasicIntegrator<FakeClock> rectangle("rectangle", IntegrationRule::Rectangle),
+                               trapezoid("trapezoid", IntegrationRule::Trapezoidal),
+                               simpson("simpson", IntegrationRule::Simpson);
+    for (double t : times) {
+        rectangle.update(f(t), at_seconds(t));
+        trapezoid.update(f(t), at_seconds(t));
+        simpson.update(f(t), at_seconds(t));
+    }
+    // Simpson's rule is exact for quadratics, even with unequal widths
+    EXPECT_NEAR(simpson.value(), 6.0, 1e-9);
+    EXPECT_NEAR(trapezoid.value(), 6.0, 0.1);
+    EXPECT_NEAR(rectangle.value(), 6.0, 1.5);
+    EXPECT_LT(std::abs(trapezoid.value() - 6.0), std::abs(rectangle.value() - 6.0));
+    EXPECT_EQ(simpson.get_rule(), IntegrationRule::Simpson);
+}
+
+// Test that an unpaired Simpson interval falls back to the trapezoid rule
+TEST(BasicIntegratorTest, SimpsonOddIntervals) {
+    BasicIntegrator<FakeClock> simpson("simpson", IntegrationRule::Simpson);
+    simpson.update(1.0, at_seconds(0.0));
+    simpson.update(3.0, at_seconds(1.0));
+    EXPECT_DOUBLE_EQ(simpson.value(), 2.0);
+    simpson.update(3.0, at_seconds(1.0));   // repeated timestamp adds nothing
+    EXPECT_DOUBLE_EQ(simpson.value(), 2.0);
+    EXPECT_THROW(simpson.update(1.0, at_seconds(0.5)), std::invalid_argument);
+    simpson.reset();
+    EXPECT_DOUBLE_EQ(simpson.value(), 0.0);
+}
+
+// Streams samples through an Integrator, recording value() after each one
+std::vector<double> streamed(const std::vector<double>& values, const std::vector<double>& times,
+                             IntegrationRule rule) {
+    BasicIntegrator<FakeClock> integrator("stream", rule);
+    std::vector<double> result;
+    for (std::size_t i = 0; i < values.size(); i++) {
+        integrator.update(values[i], at_seconds(times[i]));
+        result.push_back(integrator.value());
+    }
+    return result;
+}
+
+// Test that batch integration matches streaming updates for every rule
+TEST(BatchIntegrationTest, MatchesStreaming) {
+    std::vector<double> values, times;
+    double t = 0.0;
+    for (int i = 0; i < 200001; i++) {
+        values.push_back(std::sin(0.001 * i) + 0.5 * (i % 7));
+        times.push_back(t);
+        t += 0.001 * (1 + i % 3);   // uneven, exactly representable in nanoseconds
+    }
+    for (IntegrationRule rule : {IntegrationRule::Rectangle, IntegrationRule::Trapezoidal,
+                                 IntegrationRule::Simpson}) {
+        std::vector<double> expected = streamed(values, times, rule);
+        for (unsigned threads : {1u, 3u}) {
+            std::vector<double> cumulative = cumulative_integrate(values, times, rule, threads);
+            ASSERT_EQ(cumulative.size(), values.size());
+            EXPECT_EQ(cumulative[0], 0.0);
+            for (std::size_t i = 0; i < values.size(); i += 997) {
+                EXPECT_NEAR(cumulative[i], expected[i], 1e-9 * (1 + std::abs(expected[i])));
+            }
+            EXPECT_NEAR(cumulative.back(), expected.back(), 1e-9 * std::abs(expected.back()));
+        }
+        EXPECT_NEAR(integrate(values.data(), times.data(), values.size(), rule),
+                    expected.back(), 1e-9 * std::abs(expected.back()));
+    }
+}
+
+// Test that repeated timestamps are skipped the same way by both APIs,
+// including runs of them across block and thread boundaries
+TEST(BatchIntegrationTest, RepeatedTimes) {
+    std::vector<double> values, times;
+    double t = 0.0;
+    for (int i = 0; i < 200001; i++) {
+        values.push_back(std::cos(0.002 * i) + 0.25 * (i % 5));
+        times.push_back(t);
+        bool repeat = i % 7 == 3 || i % 1000 < 3 || (i > 66000 && i < 66700);
+        if (!repeat) {
+            t += 0.001 * (1 + i % 2);
+        }
+    }
+    for (IntegrationRule rule : {IntegrationRule::Rectangle, IntegrationRule::Trapezoidal,
+                                 IntegrationRule::Simpson}) {
+        std::vector<double> expected = streamed(values, times, rule);
+        for (unsigned threads : {1u, 3u}) {
+            std::vector<double> cumulative = cumulative_integrate(values, times, rule, threads);
+            for (std::size_t i = 0; i < values.size(); i += 331) {
+                EXPECT_NEAR(cumulative[i], expected[i], 1e-9 * (1 + std::abs(expected[i])));
+            }
+            EXPECT_NEAR(cumulative.back(), expected.back(), 1e-9 * std::abs(expected.back()));
+        }
+        EXPECT_NEAR(integrate(values.data(), times.data(), values.size(), rule),
+                    expected.back(), 1e-9 * std::abs(expected.back()));
+    }
+
+    // A zero step adds nothing
+    EXPECT_EQ(integrate(values.data(), 0.0, values.size(), IntegrationRule::Simpson), 0.0);
+}
+
+// Test the fixed step overloads against explicit times
+TEST(BatchIntegrationTest, FixedStep) {
+    // Integral of 3t^2 - 2t + 1 over [0, 2] is 6
+    std::vector<double> values, times;
+    for (int i = 0; i <= 20; i++) {
+        double t = 0.1 * i;
+        values.push_back(3 * t * t - 2 * t + 1);
+        times.push_back(t);
+    }
+    EXPECT_NEAR(integrate(values.data(), 0.1, values.size(), IntegrationRule::Simpson), 6.0, 1e-12);
+    std::vector<double> fixed(values.size());
+    cumulative_integrate(values.data(), 0.1, values.size(), fixed.data(), IntegrationRule::Trapezoidal);
+    std::vector<double> sampled = cumulative_integrate(values, times, IntegrationRule::Trapezoidal);
+    for (std::size_t i = 0; i < values.size(); i++) {
+        EXPECT_NEAR(fixed[i], sampled[i], 1e-12);
+    }
+}
+
+// Test degenerate inputs and invalid times
+TEST(BatchIntegrationTest, EdgeCases) {
+    double one = 5.0, time = 1.0;
+    EXPECT_DOUBLE_EQ(integrate(&one, &time, 1), 0.0);
+    EXPECT_DOUBLE_EQ(integrate(&one, &time, 0), 0.0);
+
+    std::vector<double> values = {1.0, 2.0, 3.0},
+                        decreasing = {0.0, 1.0, 0.5},
+                        repeated = {0.0, 1.0, 1.0};
+    EXPECT_THROW(integrate(values.data(), decreasing.data(), 3), std::invalid_argument);
+    EXPECT_THROW(cumulative_integrate(values, decreasing), std::invalid_argument);
+    EXPECT_DOUBLE_EQ(integrate(values.data(), repeated.data(), 3, IntegrationRule::Trapezoidal), 1.5);
+    EXPECT_DOUBLE_EQ(integrate(values.data(), repeated.data(), 3, IntegrationRule::Simpson), 1.5);
+    EXPECT_THROW(cumulative_integrate(values, std::vector<double>(2)), std::invalid_argument);
+}
+
+// Test a source, filter and integrator pipeline run by the manager
+TEST(ProcessManagerTest, Pipeline) {
+    RandomProcess source("source", HistoryPolicy::None);
+    Filter filter("filter");
+    Integrator integrator("integrator", IntegrationRule::Trapezoidal);
+
+    ProcessManager manager;
+    manager.add(source, std::chrono::milliseconds(1));
+    manager.add(filter, std::chrono::milliseconds(2));
+    manager.add(integrator, std::chrono::milliseconds(5));
+    manager.connect("source", "filter");
+    manager.connect("filter", "integrator");
+    EXPECT_EQ(manager.size(), 3);
+
+    manager.run_for(std::chrono::milliseconds(200), 2);
+    EXPECT_FALSE(manager.is_running());
+
+    std::vector<ProcessStats> stats = manager.stats();
+    ASSERT_EQ(stats.size(), 3);
+    EXPECT_EQ(stats[0].name, "source");
+    EXPECT_EQ(stats[1].period, std::chrono::milliseconds(2));
+    for (const ProcessStats& s : stats) {
+        // Runs at most once per period, with slack for stop() not being instant
+        EXPECT_GT(s.updates, 5);
+        EXPECT_LE(s.updates, 300 / (s.period / std::chrono::milliseconds(1)));
+        EXPECT_GE(s.average_latency.count(), 0);
+    }
+    EXPECT_DOUBLE_EQ(manager.output("source"), source.latest());
+    EXPECT_GE(manager.output("filter"), 0.0);
+    EXPECT_LE(manager.output("filter"), 1.0);
+    EXPECT_GT(integrator.value(), 0.0);
+}
+
+// Test that a process slower than its period records overruns
+TEST(ProcessManagerTest, Overruns) {
+    ProcessManager manager;
+    manager.add("slow", std::chrono::milliseconds(1), [](double) {
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        return 1.0;
+    });
+    manager.run_for(std::chrono::milliseconds(100), 1);
+    ProcessStats slow = manager.stats("slow");
+    EXPECT_GT(slow.updates, 0);
+    EXPECT_GT(slow.overruns, slow.updates);
+    EXPECT_GE(slow.last_latency, std::chrono::milliseconds(5));
+    EXPECT_DOUBLE_EQ(manager.output("slow"), 1.0);
+}
+
+// Test that an update that throws stops only its own process
+TEST(ProcessManagerTest, ThrowingUpdate) {
+    ProcessManager manager;
+    std::atomic<int> calls{0};
+    manager.add("bad", std::chrono::milliseconds(1), [&calls](double) -> double {
+        calls++;
+        throw std::runtime_error("bad update");
+    });
+    manager.add("good", std::chrono::milliseconds(1), [](double) { return 1.0; });
+    manager.run_for(std::chrono::milliseconds(50), 2);
+
+    EXPECT_EQ(calls.load(), 1);
+    ProcessStats bad = manager.stats("bad");
+    EXPECT_TRUE(bad.failed);
+    EXPECT_EQ(bad.updates, 0);
+    ASSERT_TRUE(manager.error("bad") != nullptr);
+    EXPECT_THROW(std::rethrow_exception(manager.error("bad")), std::runtime_error);
+
+    ProcessStats good = manager.stats("good");
+    EXPECT_FALSE(good.failed);
+    EXPECT_GT(good.updates, 1);
+    EXPECT_TRUE(manager.error("good") == nullptr);
+}
+
+// Test that thousands of processes all get scheduled
+TEST(ProcessManagerTest, ThousandsOfProcesses) {
+    const int n = 2000;
+    std::vector<std::atomic<int>> counts(n);
+    ProcessManager manager;
+    for (int i = 0; i < n; i++) {
+        std::atomic<int>* count = &counts[i];
+        manager.add("p" + std::to_string(i), std::chrono::milliseconds(20), [count](double) {
+            return (double) ++*count;
+        });
+    }
+    manager.run_for(std::chrono::milliseconds(150), 4);
+    for (int i = 0; i < n; i++) {
+        EXPECT_GT(counts[i].load(), 0);
+        EXPECT_LE(counts[i].load(), 9);
+        EXPECT_EQ(manager.stats("p" + std::to_string(i)).updates, (std::uint64_t) counts[i].load());
+    }
+}
+
+// Test invalid registrations
+TEST(ProcessManagerTest, Errors) {
+    ProcessManager manager;
+    manager.add("a", std::chrono::milliseconds(1), [](double x) { return x; });
+    EXPECT_THROW(manager.add("a", std::chrono::milliseconds(1), [](double x) { return x; }),
+                 std::invalid_argument);
+    EXPECT_THROW(manager.add("b", std::chrono::milliseconds(0), [](double x) { return x; }),
+                 std::invalid_argument);
+    EXPECT_THROW(manager.connect("a", "missing"), std::invalid_argument);
+    EXPECT_THROW(manager.connect("a", "a"), std::invalid_argument);
+    EXPECT_THROW(manager.stats("missing"), std::invalid_argument);
+
+    manager.start(1);
+    EXPECT_TRUE(manager.is_running());
+    EXPECT_THROW(manager.add("c", std::chrono::milliseconds(1), [](double x) { return x; }),
+                 std::logic_error);
+    manager.stop();
+    manager.stop();
+}
+
+// Test channel semantics on one thread: full, empty, wrap-around, batches
+template <typename Channel>
+void check_channel_basics() {
+    Channel channel(5);
+    EXPECT_EQ(channel.capacity(), 8);
+    double x = 0.0;
+    EXPECT_FALSE(channel.try_pop(x));
+    for (int i = 0; i < 8; i++) {
+        EXPECT_TRUE(channel.try_push(i));
+    }
+    EXPECT_FALSE(channel.try_push(8));
+    EXPECT_EQ(channel.size(), 8);
+    EXPECT_TRUE(channel.try_pop(x));
+    EXPECT_DOUBLE_EQ(x, 0.0);
+
+    // Batches that wrap around the end of the ring
+    double in[6] = {8, 9, 10, 11, 12, 13}, out[10];
+    EXPECT_EQ(channel.push_n(in, 6), 1);
+    EXPECT_EQ(channel.pop_n(out, 5), 5);
+    EXPECT_EQ(channel.push_n(in + 1, 5), 5);
+    EXPECT_EQ(channel.pop_n(out, 10), 8);
+    for (int i = 0; i < 8; i++) {
+        EXPECT_DOUBLE_EQ(out[i], 6 + i);
+    }
+    EXPECT_EQ(channel.size(), 0);
+    EXPECT_THROW(Channel(0), std::invalid_argument);
+}
+
+TEST(ChannelTest, Basics) {
+    check_channel_basics<SpscChannel<double>>();
+    check_channel_basics<MpscChannel<double>>();
+}
+
+// Test that a million values cross between two threads intact and in order
+TEST(ChannelTest, SpscAcrossThreads) {
+    const long n = 1000000;
+    SpscChannel<long> channel(1024);
+    std::thread producer([&]() {
+        long batch[7];
+        for (long i = 0; i < n;) {
+            if (i % 3 == 0) {
+                if (channel.try_push(i)) {
+                    i++;
+                }
+            } else {
+                long count = std::min(7L, n - i);
+                for (long j = 0; j < count; j++) {
+                    batch[j] = i + j;
+                }
+                i += channel.push_n(batch, count);
+            }
+            std::this_thread::yield();
+        }
+    });
+    // size() from a third thread stays within capacity while both sides run
+    std::atomic<bool> done{false};
+    std::size_t largest = 0;
+    std::thread watcher([&]() {
+        while (!done.load()) {
+            largest = std::max(largest, channel.size());
+            std::this_thread::yield();
+        }
+    });
+    long expected = 0, buffer[64];
+    bool in_order = true;
+    while (expected < n) {
+        std::size_t count = channel.pop_n(buffer, 64);
+        for (std::size_t j = 0; j < count; j++) {
+            in_order = in_order && buffer[j] == expected++;
+        }
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+    }
+    producer.join();
+    done.store(true);
+    watcher.join();
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(channel.size(), 0);
+    EXPECT_LE(largest, channel.capacity());
+}
+
+// Test fan-in: every value arrives once, each producer's in order
+TEST(ChannelTest, MpscFanIn) {
+    const int producers = 4, n = 100000;
+    MpscChannel<int> channel(256);
+    std::vector<std::thread> threads;
+    for (int p = 0; p < producers; p++) {
+        threads.push_back(std::thread([&channel, p]() {
+            // Even producers push one at a time, odd ones in batches
+            int batch[10];
+            for (int i = 0; i < n;) {
+                if (p % 2 == 0) {
+                    if (channel.try_push(p * n + i)) {
+                        i++;
+                        continue;
+                    }
+                } else {
+                    int count = std::min(10, n - i);
+                    for (int j = 0; j < count; j++) {
+                        batch[j] = p * n + i + j;
+                    }
+                    std::size_t pushed = channel.push_n(batch, count);
+                    i += pushed;
+                    if (pushed) {
+                        continue;
+                    }
+                }
+                std::this_thread::yield();
+            }
+        }));
+    }
+    std::vector<int> next(producers, 0);
+    bool in_order = true;
+    int received = 0, buffer[32];
+    while (received < producers * n) {
+        std::size_t count = channel.pop_n(buffer, 32);
+        for (std::size_t j = 0; j < count; j++) {
+            int p = buffer[j] / n;
+            in_order = in_order && buffer[j] % n == next[p]++;
+        }
+        received += count;
+        if (count == 0) {
+            std::this_thread::yield();
+        }
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_TRUE(in_order);
+    EXPECT_EQ(next, std::vector<int>(producers, n));
+}
+
+// Test the process adapters: a filter fed from a channel, an integrator
+// publishing to one
+TEST(ChannelTest, Adapters) {
+    SpscChannel<double> samples(1024);
+    Filter direct("direct"), fed("fed");
+    EmaFilter ema("ema", 0.5);
+    for (int i = 0; i < 1000; i++) {
+        samples.try_push(i % 13);
+        direct.update(i % 13);
+    }
+    EXPECT_EQ(consume(samples, fed, 600), 600);
+    EXPECT_EQ(consume(samples, fed), 400);
+    EXPECT_EQ(consume(samples, fed), 0);
+    EXPECT_NEAR(fed.value(), direct.value(), 1e-12);
+
+    samples.try_push(4.0);
+    EXPECT_EQ(consume(samples, ema), 1);   // single value updates
+    EXPECT_DOUBLE_EQ(ema.value(), 4.0);
+
+    MpscChannel<double> totals(4);
+    BasicIntegrator<FakeClock> integrator("integrator");
+    integrator.update(2.0, at_seconds(0.0));
+    integrator.update(2.0, at_seconds(1.5));
+    EXPECT_TRUE(publish(integrator, totals));
+    double total = 0.0;
+    EXPECT_TRUE(totals.try_pop(total));
+    EXPECT_DOUBLE_EQ(total, 3.0);
+}
+
+// A region timed with SCOPED_TIMER, n times
+void timed_region(int n) {
+    for (int i = 0; i < n; i++) {
+        SCOPED_TIMER("test.region");
+        std::this_thread::yield();
+    }
+}
+
+// Test that timings from several threads are combined per name
+TEST(ScopedTimerTest, AggregatesAcrossThreads) {
+    TimerRegistry& registry = TimerRegistry::instance();
+    registry.reset();
+    std::vector<std::thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.push_back(std::thread(timed_region, 1000));
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    {
+        SCOPED_TIMER("test.slow");
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    timed_region(500);   // a thread whose slot already exists
+    {
+        SCOPED_TIMER("test.outer"); SCOPED_TIMER("test.inner");   // one line, two sites
+    }
+    {
+        SCOPED_TIMER("test.\"tab\"\there");
+    }
+
+    std::vector<TimerReport> reports = registry.report();
+    auto region = std::find_if(reports.begin(), reports.end(),
+                               [](const TimerReport& r) { return r.name == "test.region"; });
+    auto slow = std::find_if(reports.begin(), reports.end(),
+                             [](const TimerReport& r) { return r.name == "test.slow"; });
+    ASSERT_NE(region, reports.end());
+    ASSERT_NE(slow, reports.end());
+    EXPECT_EQ(region->count, 4500);
+    EXPECT_EQ(slow->count, 1);
+    for (const char* name : {"test.outer", "test.inner"}) {
+        auto it = std::find_if(reports.begin(), reports.end(),
+                               [name](const TimerReport& r) { return r.name == name; });
+        ASSERT_NE(it, reports.end());
+        EXPECT_EQ(it->count, 1);
+    }
+    EXPECT_GE(slow->min, 5000000);
+    EXPECT_EQ(slow->min, slow->max);
+    EXPECT_LE(region->min, region->p50);
+    EXPECT_LE(region->p50, region->p99);
+    EXPECT_LE(region->p999, region->max);
+    EXPECT_NEAR(region->mean * region->count, (double) region->total, 1.0);
+
+    // Sorted by total time, largest first
+    for (std::size_t i = 1; i < reports.size(); i++) {
+        EXPECT_GE(reports[i - 1].total, reports[i].total);
+    }
+
+    std::string text = registry.text_report(), json = registry.json_report();
+    EXPECT_NE(text.find("test.region"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\": \"test.slow\", \"count\": 1,"), std::string::npos);
+    EXPECT_NE(json.find("{\"name\": \"test.\\\"tab\\\"\\u0009here\", \"count\": 1,"), std::string::npos);
+    EXPECT_EQ(json.front(), '[');
+
+    registry.reset();
+    for (const TimerReport& r : registry.report()) {
+        EXPECT_NE(r.name, "test.region");
+    }
+}
+
+TEST(ConcurrentStopwatchTest, Basics) {
+    ConcurrentStopwatch watch;
+    EXPECT_EQ(watch.count(), 0);
+    EXPECT_EQ(watch.get_ticks(), 0);
+
+    watch.add_ticks(1500);
+    watch.stop(watch.start());
+    {
+        auto interval = watch.time();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+    }
+    EXPECT_EQ(watch.count(), 3);
+    EXPECT_GE(watch.get_milliseconds(), 5.0);
+
+    auto interval = watch.time();
+    interval.stop();
+    interval.stop();   // only counted once
+    EXPECT_EQ(watch.count(), 4);
+
+    watch.reset();
+    EXPECT_EQ(watch.count(), 0);
+    EXPECT_EQ(watch.get_ticks(), 0);
+    watch.add_ticks(7);
+    ConcurrentStopwatch::Snapshot s = watch.snapshot();
+    EXPECT_EQ(s.count, 1);
+    EXPECT_EQ(s.total, 7);
+}
+
+// Many threads record fixed intervals while another thread reads; every
+// snapshot must pair a total with its own count. Run under
+// ThreadSanitizer with "make tsan".
+TEST(ConcurrentStopwatchTest, StressAcrossThreads) {
+    const int writers = 8, per_writer = 20000;
+    const unsigned threads_total = ConcurrentStopwatch::SLOTS + 8;   // some share the overflow slot
+    ConcurrentStopwatch watch;
+    std::atomic<bool> done(false);
+    std::atomic<int> torn(0);
+
+    std::thread reader([&]() {
+        while (!done.load()) {
+            ConcurrentStopwatch::Snapshot s = watch.snapshot();
+            if (s.total != 3 * (std::int64_t) s.count) {
+                torn++;
+            }
+        }
+    });
+    std::vector<std::thread> threads;
+    for (int i = 0; i < writers; i++) {
+        threads.emplace_back([&]() {
+            for (int k = 0; k < per_writer; k++) {
+                watch.add_ticks(3);
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    done = true;
+    reader.join();
+    EXPECT_EQ(torn.load(), 0);
+    EXPECT_EQ(watch.count(), (std::uint64_t) writers * per_writer);
+    EXPECT_EQ(watch.get_ticks(), 3 * (std::int64_t) writers * per_writer);
+
+    // More live threads than slots: the extra ones still count exactly
+    watch.reset();
+    std::atomic<unsigned> started(0);
+    std::atomic<bool> release(false);
+    threads.clear();
+    for (unsigned i = 0; i < threads_total; i++) {
+        threads.emplace_back([&]() {
+            watch.add_ticks(2);
+            started++;
+            while (!release.load()) {
+                std::this_thread::yield();
+            }
+            auto interval = watch.time();
+        });
+    }
+    while (started.load() < threads_total) {
+        std::this_thread::yield();
+    }
+    release = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(watch.count(), 2 * threads_total);
+    EXPECT_GE(watch.get_ticks(), 2 * (std::int64_t) threads_total);
+}
+
+// Registered twice on one line, which must not collide
+void registered_benchmark(BenchmarkState& state) {
+    for (auto _ : state) {
+    }
+}
+BENCHMARK_NAMED("registered a", registered_benchmark); BENCHMARK_NAMED("registered b", registered_benchmark);
+
+// Test that every registration is kept, in order
+TEST(BenchmarkTest, NamedRegistrations) {
+    std::vector<std::string> names;
+    for (const auto& benchmark : BenchmarkRegistry::instance().all()) {
+        names.push_back(benchmark.first);
+    }
+    EXPECT_EQ(names, std::vector<std::string>({"registered a", "registered b"}));
+}
+
+TEST(BenchmarkTest, CalibratesAndReports) {
+    long runs = 0, last_iterations = 0, looped = 0;
+    BenchmarkFunction spin = [&](BenchmarkState& state) {
+        runs++;
+        last_iterations = state.iterations();
+        looped = 0;
+        double x = 1.0;
+        for (auto _ : state) {
+            x = x * 1.0000001 + 1e-9;
+            do_not_optimize(x);
+            looped++;
+        }
+        state.set_items_per_iteration(2);
+    };
+    BenchmarkOptions options;
+    options.min_time = 0.002;
+    options.repetitions = 3;
+    BenchmarkResult r = run_benchmark("spin, \"quoted\"", spin, options);
+
+    EXPECT_EQ(looped, last_iterations);
+    EXPECT_EQ(r.iterations, last_iterations);
+    EXPECT_GE(runs, 1 + 1 + 3);   // calibration, warmup, repetitions
+    EXPECT_GT(r.iterations * r.min, 0.5 * options.min_time * 1e9);
+    EXPECT_LE(r.min, r.mean);
+    EXPECT_GE(r.stddev, 0.0);
+    EXPECT_EQ(r.items, 2.0);
+
+    // Quotes survive the round trip, and long names are not cut short
+    BenchmarkResult other = r;
+    other.name = "other";
+    other.mean = 12.5;
+    BenchmarkResult long_name = r;
+    long_name.name = std::string(300, 'x') + "<\"a\", \"b\">";
+    long_name.mean = 7.25;
+    std::string path = ::testing::TempDir() + "benchmark_baseline.csv";
+    {
+        std::ofstream out(path);
+        print_benchmark_csv(out, {r, other, long_name});
+    }
+    std::map<std::string, double> baseline = benchmark_detail::read_baseline(path);
+    ASSERT_EQ(baseline.size(), 3);
+    ASSERT_EQ(baseline.count("other"), 1);
+    EXPECT_NEAR(baseline["other"], 12.5, 1e-9);
+    ASSERT_EQ(baseline.count(r.name), 1);
+    EXPECT_NEAR(baseline[r.name], r.mean, 1e-3);
+    ASSERT_EQ(baseline.count(long_name.name), 1);
+    EXPECT_NEAR(baseline[long_name.name], 7.25, 1e-9);
+    EXPECT_THROW(benchmark_detail::read_baseline(path + ".missing"), std::runtime_error);
+
+    std::ostringstream json;
+    print_benchmark_json(json, {r});
+    EXPECT_NE(json.str().find("\"name\": \"spin, \\\"quoted\\\"\""), std::string::npos);
+
+    BenchmarkFunction no_loop = [](BenchmarkState&) {};
+    EXPECT_THROW(run_benchmark("no loop", no_loop, options), std::logic_error);
+}
+
+TEST(TraceTest, RecordsAcrossThreads) {
+    TraceRecorder& recorder = TraceRecorder::instance();
+    EXPECT_THROW(recorder.enable("", 0), std::invalid_argument);
+    recorder.clear();
+    {
+        TRACE_SCOPE("trace.off");   // not enabled yet
+    }
+    EXPECT_EQ(recorder.event_count(), 0);
+
+    // Naming a thread while tracing is off gives it no buffer; the name is
+    // kept for its first event
+    std::thread([&recorder]() {
+        recorder.set_thread_name("named while off");
+        recorder.enable("", 4);
+        TRACE_SCOPE("trace.named");
+    }).join();
+    recorder.disable();
+    std::thread([&recorder]() { recorder.set_thread_name("never traced"); }).join();
+    std::string named = recorder.json();
+    EXPECT_NE(named.find("\"args\": {\"name\": \"named while off\"}"), std::string::npos);
+    EXPECT_EQ(named.find("never traced"), std::string::npos);
+    recorder.clear();
+
+    // New threads get buffers of 4 events; the rest are dropped
+    recorder.enable("", 4);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < 3; i++) {
+        threads.emplace_back([&recorder, i]() {
+            recorder.set_thread_name("tracer \"" + std::to_string(i) + "\"");
+            for (int k = 0; k < 10; k++) {
+                TRACE_SCOPE("trace.scope");
+            }
+        });
+    }
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    EXPECT_EQ(recorder.event_count(), 12);
+    EXPECT_EQ(recorder.dropped_count(), 18);
+
+    // Scoped timers and process updates are traced too
+    recorder.enable("", TraceRecorder::DEFAULT_CAPACITY);
+    recorder.clear();
+    std::thread([]() {
+        SCOPED_TIMER("trace.timer");
+        std::this_thread::sleep_for(std::chrono::milliseconds(2));
+    }).join();
+    ProcessManager manager;
+    manager.add("traced process", std::chrono::milliseconds(1), [](double) { return 1.0; });
+    manager.run_for(std::chrono::milliseconds(20), 1);
+    recorder.disable();
+    std::size_t events = recorder.event_count();
+    {
+        TRACE_SCOPE("trace.off");
+    }
+    EXPECT_EQ(recorder.event_count(), events);
+
+    std::string json = recorder.json();
+    EXPECT_EQ(json.find("{\"traceEvents\": ["), 0);
+    EXPECT_NE(json.find("{\"name\": \"trace.timer\", \"ph\": \"X\", \"pid\": 1, \"tid\": "), std::string::npos);
+    EXPECT_NE(json.find("{\"name\": \"traced process\", \"ph\": \"X\""), std::string::npos);
+    EXPECT_NE(json.find("\"args\": {\"name\": \"worker 0\"}"), std::string::npos);
+    EXPECT_NE(json.find("\"args\": {\"name\": \"tracer \\\"1\\\"\"}"), std::string::npos);
+    EXPECT_EQ(json.find("trace.off"), std::string::npos);
+    EXPECT_NE(json.find("\"dropped_events\": 0}"), std::string::npos);
+
+    std::size_t at = json.find("\"dur\": ", json.find("trace.timer"));
+    ASSERT_NE(at, std::string::npos);
+    EXPECT_GE(std::atof(json.c_str() + at + 7), 2000.0);   // microseconds
+
+    recorder.clear();
+}